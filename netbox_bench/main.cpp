@@ -0,0 +1,336 @@
+#include "sensor_interface/sensorcontroller.h"
+#include "sensor_interface/netboxrdtclient.h"
+#include "sensor_interface/staticsensorcontroller.h"
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+#include <vector>
+#include <functional>
+
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+using namespace estimation::sensor_interface;
+
+namespace {
+std::atomic<uint64_t> allocations{0};
+}
+
+// Count every heap allocation, including Eigen's, which calls malloc directly rather than operator new.
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *pointer, std::size_t size);
+void *__libc_memalign(std::size_t alignment, std::size_t size);
+
+void *malloc(std::size_t size)
+{
+    allocations.fetch_add(1u, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(std::size_t count, std::size_t size)
+{
+    allocations.fetch_add(1u, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, std::size_t size)
+{
+    allocations.fetch_add(1u, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+
+void *aligned_alloc(std::size_t alignment, std::size_t size)
+{
+    allocations.fetch_add(1u, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **pointer, std::size_t alignment, std::size_t size)
+{
+    allocations.fetch_add(1u, std::memory_order_relaxed);
+    *pointer = __libc_memalign(alignment, size);
+    return *pointer ? 0 : ENOMEM;
+}
+}
+
+namespace {
+struct Result
+{
+    std::string stage;
+    std::size_t listeners;
+    std::size_t records_per_packet;
+    double ns_per_sample;
+    double allocations_per_sample;
+};
+
+struct SumSink
+{
+    double sum = 0.0;
+
+    void operator()(const SensorSample &sample)
+    {
+        sum += sample.load[0] + sample.load[5];
+    }
+};
+
+std::vector<unsigned char> makeWire(std::size_t records)
+{
+    std::vector<unsigned char> wire(records * RTD_RESPONSE_SIZE);
+    for(std::size_t i = 0; i < records; i++)
+    {
+        uint32_t words[9] = {uint32_t(i), uint32_t(i), 0u, uint32_t(1000000 + i), uint32_t(-2000000), 3000000u, 40000u, 50000u, uint32_t(-60000)};
+        for(std::size_t w = 0; w < 9; w++)
+        {
+            auto network = htonl(words[w]);
+            std::memcpy(&wire[i * RTD_RESPONSE_SIZE + w * 4u], &network, sizeof(network));
+        }
+    }
+    return wire;
+}
+
+#ifdef NETBOX_LINUX_SOCKET
+// Stands in for a Netbox on loopback: learns the client's address from its start request and sends it prepared
+// datagrams.
+class LoopbackNetbox
+{
+public:
+    LoopbackNetbox(const std::string &address, uint16_t port)
+    : m_fd(::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP))
+    , m_client{}
+    {
+        int reuse = 1;
+        ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in local{};
+        local.sin_family = AF_INET;
+        local.sin_port = htons(port);
+        if(::inet_pton(AF_INET, address.c_str(), &local.sin_addr) != 1 ||
+           ::bind(m_fd, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0)
+            throw std::runtime_error("Unable to bind loopback Netbox to " + address + ":" + std::to_string(port) + ": " + std::strerror(errno));
+    }
+
+    ~LoopbackNetbox()
+    {
+        ::close(m_fd);
+    }
+
+    // Blocks until a client sends its start request.
+    void acceptClient()
+    {
+        unsigned char request[RTD_REQUEST_SIZE];
+        socklen_t length = sizeof(m_client);
+        if(::recvfrom(m_fd, request, sizeof(request), 0, reinterpret_cast<sockaddr*>(&m_client), &length) < 0)
+            throw std::runtime_error(std::string("No start request from the client: ") + std::strerror(errno));
+    }
+
+    void send(const unsigned char *data, std::size_t size)
+    {
+        if(::sendto(m_fd, data, size, 0, reinterpret_cast<const sockaddr*>(&m_client), sizeof(m_client)) < 0)
+            throw std::runtime_error(std::string("Unable to send datagram: ") + std::strerror(errno));
+    }
+
+private:
+    int m_fd;
+    sockaddr_in m_client;
+};
+#endif
+
+// Runs body() repeats times and keeps the fastest run; body returns the nanoseconds spent in the measured part.
+Result measureTimed(const std::string &stage, std::size_t listeners, std::size_t records_per_packet, std::size_t samples,
+                    std::size_t repeats, const std::function<double()> &body)
+{
+    body();
+    double best = 1e300;
+    uint64_t allocated = 0u;
+    for(std::size_t r = 0; r < repeats; r++)
+    {
+        auto allocations_before = allocations.load();
+        auto elapsed = body();
+        allocated = allocations.load() - allocations_before;
+        best = std::min(best, elapsed);
+    }
+    return {stage, listeners, records_per_packet, best / samples, double(allocated) / samples};
+}
+
+Result measure(const std::string &stage, std::size_t listeners, std::size_t records_per_packet, std::size_t samples,
+               std::size_t repeats, const std::function<void()> &body)
+{
+    return measureTimed(stage, listeners, records_per_packet, samples, repeats, [&]()
+    {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    });
+}
+}
+
+int main(int argc, char **argv)
+{
+    std::size_t samples = 1u << 18;
+    std::size_t repeats = 5u;
+    [[maybe_unused]] std::string address = "127.0.0.3";
+    [[maybe_unused]] uint16_t port = 49160u;
+    for(int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string option = argv[i];
+        if(option == "--samples")
+            samples = std::stoul(argv[i + 1]);
+        else if(option == "--repeats")
+            repeats = std::stoul(argv[i + 1]);
+        else if(option == "--address")
+            address = argv[i + 1];
+        else if(option == "--port")
+            port = static_cast<uint16_t>(std::stoul(argv[i + 1]));
+    }
+
+    std::vector<Result> results;
+#ifdef NETBOX_LINUX_SOCKET
+    LoopbackNetbox netbox(address, port);
+#endif
+    auto wire = makeWire(samples);
+    std::vector<RTDResponse> records(samples);
+    volatile int32_t decode_sink = 0;
+
+    results.push_back(measure("decode", 0u, 1u, samples, repeats, [&]()
+    {
+        for(std::size_t i = 0; i < samples; i++)
+            records[i] = RdtCodec::decode(&wire[i * RTD_RESPONSE_SIZE]);
+        decode_sink = records[samples - 1u].fx;
+    }));
+
+    results.push_back(measure("decode", 0u, RTD_MAX_DATAGRAM_SIZE / RTD_RESPONSE_SIZE, samples, repeats, [&]()
+    {
+        constexpr std::size_t per_packet = RTD_MAX_DATAGRAM_SIZE / RTD_RESPONSE_SIZE;
+        for(std::size_t offset = 0; offset < samples; offset += per_packet)
+        {
+            auto bytes = std::min(per_packet, samples - offset) * RTD_RESPONSE_SIZE;
+            RdtCodec::decode(std::span<const unsigned char>(&wire[offset * RTD_RESPONSE_SIZE], bytes), &records[offset]);
+        }
+        decode_sink = records[samples - 1u].fx;
+    }));
+
+    for(std::size_t listener_count : {0u, 1u, 4u, 16u})
+    {
+        SensorController controller(1u << 16);
+        double sink = 0.0;
+        for(std::size_t l = 0; l < listener_count; l++)
+        {
+            controller.addSensorReadingReceivedListener([&sink](const Eigen::Vector3d &force, const Eigen::Vector3d &torque)
+            {
+                sink += force.x() + torque.z();
+            });
+        }
+        auto received = std::chrono::system_clock::now();
+        results.push_back(measure(listener_count == 0u ? "convert" : "dispatch", listener_count, 1u, samples, repeats, [&]()
+        {
+            for(std::size_t i = 0; i < samples; i++)
+                controller.ingest(std::span<const RTDResponse>(&records[i], 1u), received);
+        }));
+
+#ifdef NETBOX_LINUX_SOCKET
+        // The full per-datagram path: recvmmsg(), decode and unit split in NetboxRdtClient, and its std::function hop
+        // into SensorController::ingest(). Only the time spent in poll() is counted, not the sends feeding it.
+        NetboxRdtClient client;
+        controller.attach(client);
+        NetboxStreamSettings settings;
+        settings.receive_thread = false;
+        settings.stall_timeout = std::chrono::milliseconds::zero();
+        settings.receive_buffer_size = 4 << 20;
+        client.openStream(address, port, settings);
+        netbox.acceptClient();
+        for(std::size_t per_packet : {1u, 10u})
+        {
+            auto datagrams = samples / per_packet;
+            auto size = per_packet * RTD_RESPONSE_SIZE;
+            results.push_back(measureTimed("packet", listener_count, per_packet, samples, repeats, [&]()
+            {
+                double elapsed = 0.0;
+                for(std::size_t first = 0; first < datagrams; first += LinuxRdtSocket::BATCH_SIZE)
+                {
+                    auto burst = std::min(LinuxRdtSocket::BATCH_SIZE, datagrams - first);
+                    for(std::size_t d = 0; d < burst; d++)
+                        netbox.send(&wire[(first + d) * size], size);
+                    auto start = std::chrono::steady_clock::now();
+                    for(std::size_t delivered = 0, idle = 0; delivered < burst;)
+                    {
+                        auto count = client.poll();
+                        delivered += count;
+                        idle = count == 0u ? idle + 1u : 0u;
+                        if(idle > 1000000u)
+                            throw std::runtime_error("Loopback datagrams were lost");
+                    }
+                    elapsed += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                }
+                return elapsed;
+            }));
+        }
+        client.stopStreaming();
+#endif
+    }
+
+    {
+        SensorController controller(1u << 16);
+        controller.setFilterPipeline(FilterPipeline(7000.0).notch(50.0).lowPass(200.0, 4u).movingAverage(8u).decimate(7u));
+        double sink = 0.0;
+        controller.addFilteredSampleListener([&sink](const SensorSample &sample)
+        {
+            sink += sample.load[0];
+        });
+        auto received = std::chrono::system_clock::now();
+        results.push_back(measure("filter", 1u, 1u, samples, repeats, [&]()
+        {
+            for(std::size_t i = 0; i < samples; i++)
+                controller.ingest(std::span<const RTDResponse>(&records[i], 1u), received);
+        }));
+    }
+
+    {
+        StaticSensorController<SumSink> controller;
+        std::array<RTDResponse, RTD_MAX_DATAGRAM_SIZE / RTD_RESPONSE_SIZE> batch;
+        auto received = std::chrono::system_clock::now();
+        for(std::size_t per_packet : {1u, 10u})
+        {
+            results.push_back(measure("static", 1u, per_packet, samples, repeats, [&]()
+            {
+                for(std::size_t offset = 0; offset + per_packet <= samples; offset += per_packet)
+                {
+                    for(std::size_t r = 0; r < per_packet; r++)
+                        batch[r] = RdtCodec::decode(&wire[(offset + r) * RTD_RESPONSE_SIZE]);
+                    controller.ingest(std::span<const RTDResponse>(batch.data(), per_packet), received);
+                }
+            }));
+        }
+    }
+
+    std::printf("[\n");
+    for(std::size_t i = 0; i < results.size(); i++)
+    {
+        const auto &result = results[i];
+        std::printf("  {\"stage\": \"%s\", \"listeners\": %zu, \"records_per_packet\": %zu, \"ns_per_sample\": %.3f, \"allocations_per_sample\": %.4f}%s\n",
+                    result.stage.c_str(), result.listeners, result.records_per_packet, result.ns_per_sample,
+                    result.allocations_per_sample, i + 1u < results.size() ? "," : "");
+        std::fprintf(stderr, "%-9s listeners=%-3zu records/packet=%-3zu %9.2f ns/sample %8.4f allocs/sample\n",
+                     result.stage.c_str(), result.listeners, result.records_per_packet, result.ns_per_sample,
+                     result.allocations_per_sample);
+    }
+    std::printf("]\n");
+
+    // The compile-time sink path must stay allocation free once warmed up.
+    for(const auto &result : results)
+    {
+        if(result.stage == "static" && result.allocations_per_sample != 0.0)
+        {
+            std::fprintf(stderr, "static path allocated %.4f times per sample\n", result.allocations_per_sample);
+            return 1;
+        }
+    }
+    return 0;
+}
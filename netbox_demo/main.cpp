@@ -1,8 +1,7 @@
 //Adapted from: https://github.com/ocornut/imgui/blob/master/examples/example_sdl2_opengl2/main.cpp
+#include "plothistory.h"
 #include "sensor_interface/sensorcontroller.h"
 
-#include <condition_variable>
-
 #include "imgui.h"
 #include "imgui_impl_sdl2.h"
 #include "imgui_impl_opengl3.h"
@@ -13,7 +12,10 @@
 #include <SDL_opengl.h>
 #endif
 #include <implot.h>
+#include <array>
 #include <chrono>
+#include <vector>
+#include <algorithm>
 
 #include "sensor_interface/sensorcontroller.h"
 
@@ -60,75 +62,61 @@ int main(int, char **)
     bool render = true;
     bool pause_f = false;
     bool pause_t = false;
-    std::vector<double> time_data;
-    std::vector<double> bfx, bfy, bfz;
-    std::vector<double> btx, bty, btz;
-    std::vector<double> fx, fy, fz;
-    std::vector<double> tx, ty, tz;
+    constexpr std::size_t HISTORY_SAMPLES = 1u << 16;
+    PlotHistory history(HISTORY_SAMPLES);
+    std::vector<estimation::sensor_interface::SensorSample> received(4096u);
+    uint64_t cursor = 0u;
+    estimation::sensor_interface::SampleTime start;
+    std::size_t plot_width = 1000u;
+    std::vector<double> force_time, torque_time;
+    std::array<std::vector<double>, 3> force, torque;
 
-    std::mutex mutex;
-    Eigen::Vector3d f = Eigen::Vector3d::Zero();
-    Eigen::Vector3d t = Eigen::Vector3d::Zero();
     Eigen::Vector3d fb = Eigen::Vector3d::Zero();
     Eigen::Vector3d tb = Eigen::Vector3d::Zero();
 
     auto controller = std::make_unique<estimation::sensor_interface::SensorController>("192.168.1.8", 49152u);
-    controller->addSensorReadingReceivedListener(
-        [&](const Eigen::Vector3d &force, const Eigen::Vector3d &torque)
-        {
-            std::lock_guard<std::mutex> l(mutex);
-            f = force;
-            t = torque;
-        }
-    );
-    auto push_value = [](std::vector<double> &vec, double v)
-    {
-        vec.insert(vec.begin(), v);
-        if(vec.size() == 1000u)
-            vec.pop_back();
-    };
 
     auto update_plot = [&]()
     {
+        // Drain everything received since the last frame, not just the latest sample.
+        std::size_t count = 0u;
+        do
         {
-            std::lock_guard<std::mutex> l(mutex);
-            if(time_data.size() != 1000u)
-                time_data.push_back((time_data.size() + 1u) / 100.0);
-            push_value(bfx, f.x());
-            push_value(bfy, f.y());
-            push_value(bfz, f.z());
-            push_value(btx, t.x());
-            push_value(bty, t.y());
-            push_value(btz, t.z());
+            count = controller->readSamplesSince(cursor, received);
+            for(std::size_t i = 0; i < count; i++)
+            {
+                if(start == estimation::sensor_interface::SampleTime())
+                    start = received[i].timestamp;
+                history.push(std::chrono::duration<double>(received[i].timestamp - start).count(), received[i].load);
+            }
         }
+        while(count == received.size());
+
         if(!pause_f)
         {
-            fx = bfx;
-            fy = bfy;
-            fz = bfz;
+            history.decimate(plot_width, 0u, force_time, force);
+            for(std::size_t axis = 0; axis < 3u; axis++)
+                Eigen::Map<Eigen::ArrayXd>(force[axis].data(), force[axis].size()) += fb[axis];
         }
         if(!pause_t)
         {
-            tx = btx;
-            ty = bty;
-            tz = btz;
-        }
-        for(auto i = 0; i < fx.size(); i++)
-        {
-            if(!pause_f)
-            {
-                fx[i] += fb.x();
-                fy[i] += fb.y();
-                fz[i] += fb.z();
-            }
-            if(!pause_t)
-            {
-                tx[i] += tb.x();
-                ty[i] += tb.y();
-                tz[i] += tb.z();
-            }
+            history.decimate(plot_width, 3u, torque_time, torque);
+            for(std::size_t axis = 0; axis < 3u; axis++)
+                Eigen::Map<Eigen::ArrayXd>(torque[axis].data(), torque[axis].size()) += tb[axis];
         }
     };
+
+    auto plot_line = [](const char *title, const char *label, const std::vector<double> &time, const std::vector<double> &values)
+    {
+        if(!ImPlot::BeginPlot(title))
+            return;
+        ImPlot::SetupAxes(nullptr, nullptr, 0, ImPlotAxisFlags_AutoFit);
+        if(time.size() > 1u && time.front() < time.back())
+            ImPlot::SetupAxisLimits(ImAxis_X1, time.front(), time.back(), ImGuiCond_Always);
+        ImPlot::PlotLine(label, time.data(), values.data(), static_cast<int>(values.size()));
+        ImPlot::EndPlot();
+    };
+
     while(render)
     {
         update_plot();
@@ -146,41 +134,18 @@ int main(int, char **)
         ImGui::NewFrame();
         {
             ImGui::Begin("Forces");
-            if(ImPlot::BeginPlot("Force X"))
-            {
-                ImPlot::PlotLine("Fx", &time_data[0], &fx[0], fx.size());
-                ImPlot::EndPlot();
-            }
-            if(ImPlot::BeginPlot("Force Y"))
-            {
-                ImPlot::PlotLine("Fy", &time_data[0], &fy[0], fy.size());
-                ImPlot::EndPlot();
-            }
-            if(ImPlot::BeginPlot("Force Z"))
-            {
-                ImPlot::PlotLine("Fz", &time_data[0], &fz[0], fz.size());
-                ImPlot::EndPlot();
-            }
+            plot_width = static_cast<std::size_t>(std::max(ImGui::GetContentRegionAvail().x, 1.0f));
+            plot_line("Force X", "Fx", force_time, force[0]);
+            plot_line("Force Y", "Fy", force_time, force[1]);
+            plot_line("Force Z", "Fz", force_time, force[2]);
             ImGui::End();
         }
 
         {
             ImGui::Begin("Torques");
-            if(ImPlot::BeginPlot("Torque X"))
-            {
-                ImPlot::PlotLine("Tx", &time_data[0], &tx[0], tx.size());
-                ImPlot::EndPlot();
-            }
-            if(ImPlot::BeginPlot("Torque Y"))
-            {
-                ImPlot::PlotLine("Ty", &time_data[0], &ty[0], ty.size());
-                ImPlot::EndPlot();
-            }
-            if(ImPlot::BeginPlot("Torque Z"))
-            {
-                ImPlot::PlotLine("Tz", &time_data[0], &tz[0], tz.size());
-                ImPlot::EndPlot();
-            }
+            plot_line("Torque X", "Tx", torque_time, torque[0]);
+            plot_line("Torque Y", "Ty", torque_time, torque[1]);
+            plot_line("Torque Z", "Tz", torque_time, torque[2]);
             ImGui::End();
         }
 
@@ -0,0 +1,99 @@
+#include "plothistory.h"
+
+#include <bit>
+#include <limits>
+#include <algorithm>
+
+PlotHistory::PlotHistory(std::size_t capacity)
+: m_capacity(std::bit_ceil(std::max<std::size_t>(capacity, 2u)))
+, m_head(0u)
+, m_time(m_capacity, 0.0)
+{
+    for(auto entries = m_capacity; entries > 0u; entries >>= 1)
+        m_levels.emplace_back(entries);
+}
+
+std::size_t PlotHistory::size() const
+{
+    return static_cast<std::size_t>(std::min<uint64_t>(m_head, m_capacity));
+}
+
+double PlotHistory::latestTime() const
+{
+    return m_head == 0u ? 0.0 : m_time[(m_head - 1u) & (m_capacity - 1u)];
+}
+
+void PlotHistory::push(double time, const std::array<double, 6> &load)
+{
+    auto index = m_head++;
+    m_time[index & (m_capacity - 1u)] = time;
+    m_levels[0][index & (m_capacity - 1u)] = {load, load};
+    // Every completed block of 2^k samples folds its two halves into level k.
+    for(std::size_t level = 1; level < m_levels.size() && ((index + 1u) & ((uint64_t(1) << level) - 1u)) == 0u; level++)
+    {
+        auto block_index = index >> level;
+        const auto &left = block(level - 1u, block_index * 2u);
+        const auto &right = block(level - 1u, block_index * 2u + 1u);
+        auto &merged = m_levels[level][block_index & (m_levels[level].size() - 1u)];
+        for(std::size_t channel = 0; channel < 6u; channel++)
+        {
+            merged.min[channel] = std::min(left.min[channel], right.min[channel]);
+            merged.max[channel] = std::max(left.max[channel], right.max[channel]);
+        }
+    }
+}
+
+const PlotHistory::Extremes &PlotHistory::block(std::size_t level, uint64_t index) const
+{
+    const auto &entries = m_levels[level];
+    return entries[index & (entries.size() - 1u)];
+}
+
+PlotHistory::Extremes PlotHistory::range(uint64_t begin, uint64_t end) const
+{
+    Extremes extremes;
+    extremes.min.fill(std::numeric_limits<double>::infinity());
+    extremes.max.fill(-std::numeric_limits<double>::infinity());
+    while(begin < end)
+    {
+        // Largest aligned block starting at begin that still fits in the range.
+        std::size_t level = std::min<std::size_t>(std::countr_zero(begin), m_levels.size() - 1u);
+        while((uint64_t(1) << level) > end - begin)
+            level--;
+        const auto &b = block(level, begin >> level);
+        for(std::size_t channel = 0; channel < 6u; channel++)
+        {
+            extremes.min[channel] = std::min(extremes.min[channel], b.min[channel]);
+            extremes.max[channel] = std::max(extremes.max[channel], b.max[channel]);
+        }
+        begin += uint64_t(1) << level;
+    }
+    return extremes;
+}
+
+void PlotHistory::decimate(std::size_t buckets, std::size_t first_channel, std::vector<double> &time,
+                           std::span<std::vector<double>> values) const
+{
+    time.clear();
+    for(auto &channel : values)
+        channel.clear();
+    auto count = size();
+    if(count == 0u || buckets == 0u)
+        return;
+    auto oldest = m_head - count;
+    buckets = std::min(buckets, count);
+    for(std::size_t bucket = 0; bucket < buckets; bucket++)
+    {
+        auto begin = oldest + count * bucket / buckets;
+        auto end = oldest + count * (bucket + 1u) / buckets;
+        auto extremes = range(begin, end);
+        auto mid = (m_time[begin & (m_capacity - 1u)] + m_time[(end - 1u) & (m_capacity - 1u)]) / 2.0;
+        time.push_back(mid);
+        time.push_back(mid);
+        for(std::size_t channel = 0; channel < values.size(); channel++)
+        {
+            values[channel].push_back(extremes.min[first_channel + channel]);
+            values[channel].push_back(extremes.max[first_channel + channel]);
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef NETBOX_DEMO_PLOTHISTORY_H
+#define NETBOX_DEMO_PLOTHISTORY_H
+
+#include <span>
+#include <array>
+#include <vector>
+#include <cstdint>
+
+// Full-rate ring of the most recent samples with a min/max pyramid on top. Level k holds the extremes of aligned
+// blocks of 2^k samples, so any range reduces to O(log capacity) blocks and a plot can be decimated to its pixel
+// width at a cost that does not grow with the history length. Min/max decimation keeps single-sample spikes visible.
+class PlotHistory
+{
+public:
+    explicit PlotHistory(std::size_t capacity);
+
+    std::size_t size() const;
+    double latestTime() const;
+
+    void push(double time, const std::array<double, 6> &load);
+
+    // Splits the history into buckets equal ranges and emits the minimum and maximum of each range for channels
+    // first_channel .. first_channel + values.size() - 1, both at the range's mid time.
+    void decimate(std::size_t buckets, std::size_t first_channel, std::vector<double> &time,
+                  std::span<std::vector<double>> values) const;
+
+private:
+    struct Extremes
+    {
+        std::array<double, 6> min;
+        std::array<double, 6> max;
+    };
+
+    std::size_t m_capacity;
+    uint64_t m_head;
+    std::vector<double> m_time;
+    std::vector<std::vector<Extremes>> m_levels;
+
+    const Extremes &block(std::size_t level, uint64_t index) const;
+    Extremes range(uint64_t begin, uint64_t end) const;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_ASYNCDISPATCHER_H
+#define ESTIMATION_SENSOR_INTERFACE_ASYNCDISPATCHER_H
+
+#include "sensor_interface/sensorsample.h"
+
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <functional>
+
+namespace estimation::sensor_interface {
+enum class BackpressurePolicy
+{
+    // The publishing thread waits for room in the subscriber's queue.
+    BLOCK,
+    // A full queue overwrites its oldest sample.
+    DROP_OLDEST,
+    // Only the most recent sample is kept; the subscriber sees the latest value whenever it gets to run.
+    COALESCE
+};
+
+struct AsyncListenerOptions
+{
+    typedef std::function<void(std::function<void()> task)> Executor;
+
+    BackpressurePolicy policy = BackpressurePolicy::DROP_OLDEST;
+    std::size_t capacity = 1024u;
+    // Runs the subscriber's drain tasks, at most one at a time; empty uses the dispatcher's own thread.
+    Executor executor;
+};
+
+struct SubscriberStatistics
+{
+    uint64_t published = 0;
+    uint64_t delivered = 0;
+    uint64_t dropped = 0;
+    uint64_t queued = 0;
+    // Time from sample reception to listener invocation, for the latest and the slowest delivered sample.
+    std::chrono::nanoseconds lag{0};
+    std::chrono::nanoseconds max_lag{0};
+};
+
+// Moves listener calls off the receive thread. Every subscriber owns a bounded lock-free queue filled by the single
+// publishing thread and drained either by the dispatcher thread or by the subscriber's executor. Subscribers on the
+// dispatcher thread take turns in small batches, so a listener that blocks for long should bring its own executor.
+class AsyncDispatcher
+{
+public:
+    typedef std::function<void(const SensorSample &sample)> Listener;
+
+    static constexpr std::size_t MAX_SUBSCRIBERS = 64u;
+
+    AsyncDispatcher();
+    ~AsyncDispatcher();
+
+    AsyncDispatcher(const AsyncDispatcher &) = delete;
+    AsyncDispatcher &operator=(const AsyncDispatcher &) = delete;
+
+    // Subscribers only see samples published on their stream.
+    std::size_t subscribe(Listener listener, const AsyncListenerOptions &options, uint32_t stream = 0u);
+    std::size_t subscriberCount() const;
+
+    // Publishing thread only.
+    void publish(const SensorSample &sample, uint32_t stream = 0u);
+
+    SubscriberStatistics statistics(std::size_t subscriber) const;
+
+    void stop();
+
+private:
+    struct Subscriber;
+
+    std::mutex m_subscribe_lock;
+    std::array<std::shared_ptr<Subscriber>, MAX_SUBSCRIBERS> m_subscribers;
+    std::atomic<std::size_t> m_subscriber_count;
+    std::atomic<uint32_t> m_signal;
+    std::atomic<bool> m_running;
+    std::thread m_worker;
+
+    void run();
+    void wake();
+    static void schedule(const std::shared_ptr<Subscriber> &subscriber);
+};
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_CALIBRATION_H
+#define ESTIMATION_SENSOR_INTERFACE_CALIBRATION_H
+
+#include <span>
+#include <array>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace estimation::sensor_interface {
+struct RTDResponse;
+
+typedef Eigen::Matrix<double, 6, 6> Matrix6d;
+typedef Eigen::Matrix<double, 6, 1> Vector6d;
+
+// Maps raw Fx..Tz counts to a calibrated wrench in the tool frame: wrench = tool_transform * calibration * counts.
+// The combined matrix is classified once so conversion can use the cheapest kernel for it.
+class Calibration
+{
+public:
+    enum class Kind
+    {
+        IDENTITY,
+        DIAGONAL,
+        FULL
+    };
+
+    Calibration();
+
+    static Calibration fromCountsPerUnit(double count_per_force, double count_per_torque);
+    static Calibration fromMatrix(const Matrix6d &counts_to_wrench);
+
+    // Expresses the wrench in a tool frame given the pose of the sensor frame in that tool frame.
+    void setToolTransform(const Eigen::Isometry3d &tool_from_sensor);
+
+    Kind kind() const;
+    const Matrix6d &matrix() const;
+
+    void convert(std::span<const RTDResponse> records, std::array<double, 6> *wrenches) const;
+
+private:
+    Kind m_kind;
+    Matrix6d m_calibration;
+    Matrix6d m_tool_transform;
+    Matrix6d m_matrix;
+
+    void update();
+};
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_FILTERPIPELINE_H
+#define ESTIMATION_SENSOR_INTERFACE_FILTERPIPELINE_H
+
+#include <vector>
+#include <cstddef>
+
+#include <Eigen/Core>
+
+namespace estimation::sensor_interface {
+typedef Eigen::Array<double, 6, 1> Channels;
+
+struct BiquadCoefficients
+{
+    double b0 = 1.0;
+    double b1 = 0.0;
+    double b2 = 0.0;
+    double a1 = 0.0;
+    double a2 = 0.0;
+
+    static BiquadCoefficients lowPass(double cutoff, double sample_rate, double q);
+    static BiquadCoefficients notch(double frequency, double sample_rate, double q);
+};
+
+// Chain of filter stages applied to all six Fx..Tz channels at once. Stages are configured up front and keep their
+// state preallocated, so process() neither allocates nor branches per channel. Frequencies are given in Hz at the
+// rate seen by the stage, i.e. after any earlier decimate() stage.
+class FilterPipeline
+{
+public:
+    explicit FilterPipeline(double sample_rate = 7000.0);
+
+    // Butterworth low-pass of the given even order as a cascade of order / 2 biquad sections.
+    FilterPipeline &lowPass(double cutoff, unsigned order = 2u);
+    FilterPipeline &notch(double frequency, double q = 10.0);
+    FilterPipeline &biquad(const BiquadCoefficients &coefficients);
+    FilterPipeline &movingAverage(std::size_t window);
+    FilterPipeline &decimate(unsigned factor);
+
+    bool empty() const;
+    double inputRate() const;
+    double outputRate() const;
+
+    // Filters channels in place; returns false while a decimation stage is discarding the sample. Biquads start in
+    // their steady state for the first sample so a sensor offset does not ring through the filter.
+    bool process(Channels &channels);
+    void reset();
+
+private:
+    enum class StageKind
+    {
+        BIQUAD,
+        MOVING_AVERAGE,
+        DECIMATE
+    };
+
+    struct Stage
+    {
+        StageKind kind;
+        BiquadCoefficients coefficients;
+        Channels z1 = Channels::Zero();
+        Channels z2 = Channels::Zero();
+        Channels sum = Channels::Zero();
+        std::vector<Channels> window;
+        std::size_t index = 0u;
+        std::size_t filled = 0u;
+        unsigned factor = 1u;
+        unsigned count = 0u;
+        bool primed = false;
+    };
+
+    double m_input_rate;
+    double m_output_rate;
+    std::vector<Stage> m_stages;
+};
+}
+
+#endif
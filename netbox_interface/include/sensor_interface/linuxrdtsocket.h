@@ -0,0 +1,59 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_LINUXRDTSOCKET_H
+#define ESTIMATION_SENSOR_INTERFACE_LINUXRDTSOCKET_H
+
+#include <span>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <sys/socket.h>
+
+namespace estimation::sensor_interface {
+// UDP socket that drains up to BATCH_SIZE datagrams per recvmmsg() call into a preallocated receive arena.
+class LinuxRdtSocket
+{
+public:
+    static constexpr std::size_t BATCH_SIZE = 64u;
+    static constexpr std::size_t DATAGRAM_CAPACITY = 2048u;
+
+    LinuxRdtSocket();
+    ~LinuxRdtSocket();
+
+    LinuxRdtSocket(const LinuxRdtSocket &) = delete;
+    LinuxRdtSocket &operator=(const LinuxRdtSocket &) = delete;
+
+    void open(const std::string &remote_ip, uint16_t port, int receive_buffer_size);
+    void close();
+    bool isOpen() const;
+    int nativeHandle() const;
+
+    int receiveBufferSize() const;
+    // Upper bound on how long a blocking receive() waits; 100 ms after open().
+    void setReceiveTimeout(std::chrono::microseconds timeout);
+
+    void write(const void *data, std::size_t size);
+
+    // Fills the arena with up to BATCH_SIZE datagrams and returns how many were received. A blocking call waits for
+    // the first datagram (or the receive timeout); a non-blocking call returns 0 when nothing is queued.
+    std::size_t receive(bool blocking = true);
+
+    std::span<const unsigned char> datagram(std::size_t index) const;
+    // Kernel receive time of a datagram (SO_TIMESTAMPNS, CLOCK_REALTIME); falls back to fallback if none was attached.
+    std::chrono::system_clock::time_point timestamp(std::size_t index, std::chrono::system_clock::time_point fallback) const;
+
+private:
+    struct alignas(64) Datagram
+    {
+        unsigned char data[DATAGRAM_CAPACITY];
+        alignas(cmsghdr) unsigned char control[64];
+    };
+
+    int m_fd;
+    std::vector<iovec> m_iovecs;
+    std::vector<mmsghdr> m_headers;
+    std::vector<Datagram> m_arena;
+};
+}
+
+#endif
@@ -1,58 +1,72 @@
 #ifndef ESTIMATION_SENSOR_INTERFACE_NETBOXRDTIOSERVER_H
 #define ESTIMATION_SENSOR_INTERFACE_NETBOXRDTIOSERVER_H
 
+#ifdef NETBOX_LINUX_SOCKET
+#include "sensor_interface/linuxrdtsocket.h"
+#else
 #include "simple_socket/UDPSocket.hpp"
+#endif
+
+#include "sensor_interface/rdtcodec.h"
+#include "sensor_interface/sensorsample.h"
+#include "sensor_interface/streamstatistics.h"
 
+#include <span>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <atomic>
 #include <thread>
 #include <functional>
 
 namespace estimation::sensor_interface {
-enum class RTDCommand : uint16_t
-{
-    HEADER                           = 0x1234,
-    STOP_STREAM                      = 0x0000,
-    START_HIGH_SPEED_REALTIME_STREAM = 0x0002,
-    START_HIGH_SPEED_BUFFERED_STREAM = 0x0003,
-    START_MULTI_UNIT_STREAMING       = 0x0004,
-    RESET_THRESHOLD_LATCH            = 0x0041,
-    SET_SOFTWARE_BIAS                = 0x0042
-};
-
-struct RTDRequest
+// Opt-in tuning of the receive thread started by startStreaming(). Needs CAP_SYS_NICE / CAP_IPC_LOCK (or matching
+// rlimits) for the priority and memory locking parts; startStreaming() throws if they cannot be applied.
+struct RealtimeSettings
 {
-    RTDRequest(RTDCommand command) : RTDRequest(command, 0)
-    {
-    }
-
-    RTDRequest(RTDCommand command, uint32_t sample_count)
-    : header(static_cast<uint16_t>(RTDCommand::HEADER))
-    , command(static_cast<uint16_t>(command))
-    , sample_count(sample_count)
+    // SCHED_FIFO priority (1-99); 0 keeps the default scheduling policy.
+    int priority = 0;
+    // CPU to pin the receive thread to; -1 leaves the affinity alone.
+    int cpu = -1;
+    // mlockall() the process and prefault the receive thread's stack so no page fault lands on the receive path.
+    bool lock_memory = false;
+    // Spin on the non-blocking socket instead of sleeping in the kernel; costs a full core.
+    bool busy_poll = false;
+
+    bool enabled() const
     {
+        return priority > 0 || cpu >= 0 || lock_memory || busy_poll;
     }
-
-    uint16_t header;
-    uint16_t command;
-    uint32_t sample_count = 0;
 };
 
-struct RTDResponse
+struct NetboxStreamSettings
 {
-    uint32_t rdt_package_sequence_index;
-    uint32_t ft_internal_sequence_index;
-    uint32_t status;
-    int32_t fx;
-    int32_t fy;
-    int32_t fz;
-    int32_t tx;
-    int32_t ty;
-    int32_t tz;
+    RTDCommand command = RTDCommand::START_HIGH_SPEED_REALTIME_STREAM;
+    uint32_t sample_count = 0;
+    int receive_buffer_size = 0;
+    // Transducers behind the Netbox when streaming START_MULTI_UNIT_STREAMING; their records are interleaved in unit order.
+    uint32_t unit_count = 1;
+    // Without a receive thread startStreaming() only opens the stream; the owner drains it through poll(), typically
+    // when nativeHandle() becomes readable in its own event loop.
+    bool receive_thread = true;
+    // Continuous streams (sample_count == 0) that deliver nothing for this long are reported disconnected and the
+    // start request is re-sent on the same socket, backing off exponentially between attempts. 0 disables it.
+    // SimpleSocket reads block without a timeout, so the watchdog needs the Linux socket backend; elsewhere it is
+    // off by default and startStreaming() rejects a non-zero timeout.
+#ifdef NETBOX_LINUX_SOCKET
+    std::chrono::milliseconds stall_timeout{250};
+#else
+    std::chrono::milliseconds stall_timeout{0};
+#endif
+    std::chrono::milliseconds reconnect_backoff_min{10};
+    std::chrono::milliseconds reconnect_backoff_max{2000};
+    RealtimeSettings realtime;
 };
 
 typedef std::function<void (int32_t fx, int32_t fy, int32_t fz, int32_t tx, int32_t ty, int32_t tz)> FTSensorLoadListener;
+typedef std::function<void (std::span<const RTDResponse> batch, SampleTime received)> FTSensorBatchListener;
+typedef std::function<void (bool connected)> NetboxConnectionListener;
 
 class NetboxRdtClient
 {
@@ -60,27 +74,131 @@ public:
     NetboxRdtClient();
     ~NetboxRdtClient();
 
-    void startStreaming(const std::string &netbox_ip, uint16_t netbox_port);
+    void startStreaming(const std::string &netbox_ip, uint16_t netbox_port, const NetboxStreamSettings &settings = {});
     bool isStreaming() const;
     void stopStreaming();
 
+    // Starts the stream without a worker thread; received datagrams are dispatched from poll().
+    void openStream(const std::string &netbox_ip, uint16_t netbox_port, const NetboxStreamSettings &settings = {});
+#ifdef NETBOX_LINUX_SOCKET
+    int nativeHandle() const;
+    std::size_t poll();
+    // poll() with the handler bound at compile time instead of the registered listeners: handler(unit, batch,
+    // received) is called for every datagram's records, so decode and delivery can inline into one loop.
+    template<typename Handler>
+    std::size_t poll(Handler &&handler);
+#endif
+
+    // The listeners are read by the receive thread (or the caller of poll()) without locking, so they are registered
+    // before startStreaming() / openStream(); registering one on an open stream throws std::logic_error.
     void setSensorLoadListener(FTSensorLoadListener listener);
+    void setSensorBatchListener(FTSensorBatchListener listener, uint32_t unit = 0);
+    // Called on the receive thread when datagrams start flowing and when the stall watchdog gives up on them.
+    void addConnectionListener(NetboxConnectionListener listener);
+    bool isConnected() const;
+
+    // Stall watchdog and restart logic. The receive thread runs it after every receive; owners without a receive
+    // thread call it from their event loop at least every stall_timeout / 2.
+    void watchdog();
+
+    // Statistics of a unit the open stream does not carry can only be created before it is opened.
+    const StreamStatistics &statistics(uint32_t unit = 0);
+    StreamStatisticsSnapshot streamStatistics(uint32_t unit = 0) const;
+
+    // Commands applied by the Netbox itself: zero its readings at the current load, and clear latched threshold
+    // status bits.
+    void setSoftwareBias();
+    void resetThresholdLatch();
 
 private:
     std::thread m_worker;
     std::atomic<bool> m_connected;
     std::atomic<bool> m_streaming;
+    NetboxStreamSettings m_settings;
+    std::chrono::steady_clock::time_point m_last_datagram;
+    std::chrono::steady_clock::time_point m_next_restart;
+    std::chrono::milliseconds m_backoff;
+    std::vector<NetboxConnectionListener> m_connection_listeners;
+    uint32_t m_unit_count;
+    std::vector<RTDResponse> m_batch;
     FTSensorLoadListener m_load_listener;
+    std::vector<FTSensorBatchListener> m_batch_listeners;
+    std::vector<std::vector<RTDResponse>> m_unit_batches;
+    std::vector<std::unique_ptr<StreamStatistics>> m_statistics;
+#ifdef NETBOX_LINUX_SOCKET
+    LinuxRdtSocket m_socket;
+#else
     std::unique_ptr<simple_socket::UDPSocket> m_client;
     std::unique_ptr<simple_socket::SimpleConnection> m_client_connection;
+#endif
 
     void connectedChanged(bool connected);
+    void datagramsReceived();
 
-    std::string serialize(const RTDRequest &request);
+    void sendRequest(const RTDRequest &request);
 
-    void receiveMessage(const std::string &payload);
-    RTDResponse deserialize(const std::string &response);
+    void ensureStatistics(std::size_t units);
+    void requireClosed(const char *operation) const;
+
+    void receiveMessage(const unsigned char *payload, std::size_t size, SampleTime arrival);
+    template<typename Handler>
+    void receiveMessage(const unsigned char *payload, std::size_t size, SampleTime arrival, Handler &handler);
+    void dispatch(uint32_t unit, std::span<const RTDResponse> batch, SampleTime arrival);
 };
+
+template<typename Handler>
+void NetboxRdtClient::receiveMessage(const unsigned char *payload, std::size_t size, SampleTime arrival, Handler &handler)
+{
+    m_batch.resize(size / RTD_RESPONSE_SIZE);
+    RdtCodec::decode(std::span<const unsigned char>(payload, size), m_batch.data());
+    if(m_batch.empty())
+        return;
+    if(m_unit_count == 1u)
+    {
+        m_statistics[0]->update(m_batch, arrival);
+        handler(0u, std::span<const RTDResponse>(m_batch), arrival);
+        return;
+    }
+    for(auto &unit_batch : m_unit_batches)
+        unit_batch.clear();
+    for(std::size_t i = 0; i < m_batch.size(); i++)
+        m_unit_batches[i % m_unit_count].push_back(m_batch[i]);
+    for(uint32_t unit = 0; unit < m_unit_count; unit++)
+    {
+        if(m_unit_batches[unit].empty())
+            continue;
+        m_statistics[unit]->update(m_unit_batches[unit], arrival);
+        handler(unit, std::span<const RTDResponse>(m_unit_batches[unit]), arrival);
+    }
+}
+
+#ifdef NETBOX_LINUX_SOCKET
+template<typename Handler>
+std::size_t NetboxRdtClient::poll(Handler &&handler)
+{
+    std::size_t total = 0;
+    while(m_streaming)
+    {
+        auto count = m_socket.receive(false);
+        if(count == 0u)
+            break;
+        datagramsReceived();
+        auto now = std::chrono::system_clock::now();
+        auto wakeup = now - m_socket.timestamp(0u, now);
+        for(uint32_t unit = 0; unit < m_unit_count; unit++)
+            m_statistics[unit]->recordWakeup(wakeup);
+        for(std::size_t i = 0; i < count; i++)
+        {
+            auto datagram = m_socket.datagram(i);
+            receiveMessage(datagram.data(), datagram.size(), m_socket.timestamp(i, now), handler);
+        }
+        total += count;
+        if(count < LinuxRdtSocket::BATCH_SIZE)
+            break;
+    }
+    return total;
+}
+#endif
 }
 
 #endif
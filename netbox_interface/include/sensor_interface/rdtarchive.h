@@ -0,0 +1,112 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_RDTARCHIVE_H
+#define ESTIMATION_SENSOR_INTERFACE_RDTARCHIVE_H
+
+#include "sensor_interface/calibration.h"
+#include "sensor_interface/rdtrecorder.h"
+#include "sensor_interface/sensorsample.h"
+
+#include <span>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+
+namespace estimation::sensor_interface {
+class SensorController;
+
+struct ArchiveChunkInfo
+{
+    uint64_t offset;
+    int64_t first_ns;
+    int64_t last_ns;
+    uint64_t record_count;
+};
+
+// Writes RDT streams as independent compressed chunks. Every field is its own column: timestamps, sequence
+// indices and Fx..Tz counts are delta + zigzag + varint coded, status words and unit ids are run-length coded.
+// A footer index of chunk time ranges allows seeking without decoding.
+class RdtArchiveWriter
+{
+public:
+    static constexpr uint32_t DEFAULT_CHUNK_RECORDS = 1u << 16;
+
+    RdtArchiveWriter(const std::string &path, double count_per_force, double count_per_torque,
+                     uint32_t chunk_records = DEFAULT_CHUNK_RECORDS);
+    ~RdtArchiveWriter();
+
+    RdtArchiveWriter(const RdtArchiveWriter &) = delete;
+    RdtArchiveWriter &operator=(const RdtArchiveWriter &) = delete;
+
+    // Synchronous appends from the caller's thread. A writer is fed either through append() or through attach(),
+    // not both; mixing them throws std::logic_error.
+    void append(std::span<const RTDResponse> batch, SampleTime received, uint32_t unit = 0);
+    void append(const RecordedResponse &record);
+
+    // Archives a live controller's raw stream; compression runs on a background thread. Several controllers may be
+    // attached, and the writer may be destroyed before them.
+    void attach(SensorController &controller, uint32_t unit = 0);
+    uint64_t dropped() const;
+    // errno of the first failed write, 0 while the archive is intact. append() and close() throw it as
+    // std::runtime_error; an attached writer's background thread stops writing and leaves it here.
+    int error() const;
+
+    // Writes the index and trailer. Throws if any write failed; the destructor closes silently.
+    void close();
+
+private:
+    std::FILE *m_file;
+    std::string m_path;
+    uint64_t m_offset;
+    std::atomic<int> m_error;
+    uint32_t m_chunk_records;
+    std::vector<RecordedResponse> m_pending;
+    std::vector<ArchiveChunkInfo> m_index;
+    std::vector<std::vector<uint8_t>> m_columns;
+    bool m_appended;
+    std::shared_ptr<RecordQueue> m_queue;
+    std::atomic<bool> m_running;
+    std::thread m_worker;
+
+    void write(const void *data, std::size_t size);
+    void checkError() const;
+    void add(const RecordedResponse &record);
+    void flushChunk();
+    void drain();
+};
+
+class RdtArchiveReader
+{
+public:
+    explicit RdtArchiveReader(const std::string &path);
+    ~RdtArchiveReader();
+
+    RdtArchiveReader(const RdtArchiveReader &) = delete;
+    RdtArchiveReader &operator=(const RdtArchiveReader &) = delete;
+
+    const std::vector<ArchiveChunkInfo> &chunks() const;
+    uint64_t recordCount() const;
+    Calibration calibration() const;
+
+    // Index of the first chunk that may hold records received at or after time.
+    std::size_t findChunk(SampleTime time) const;
+
+    void readChunk(std::size_t chunk, std::vector<RecordedResponse> &records) const;
+    void readSamples(std::size_t chunk, uint32_t unit, std::vector<SensorSample> &samples) const;
+
+    void scan(const std::function<void(std::span<const RecordedResponse> records)> &visitor) const;
+
+private:
+    int m_fd;
+    const uint8_t *m_data;
+    std::size_t m_size;
+    double m_count_per_force;
+    double m_count_per_torque;
+    std::vector<ArchiveChunkInfo> m_chunks;
+};
+}
+
+#endif
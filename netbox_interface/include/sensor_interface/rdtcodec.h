@@ -0,0 +1,277 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_RDTCODEC_H
+#define ESTIMATION_SENSOR_INTERFACE_RDTCODEC_H
+
+#include <bit>
+#include <span>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <algorithm>
+#include <type_traits>
+
+namespace estimation::sensor_interface {
+enum class RTDCommand : uint16_t
+{
+    HEADER                           = 0x1234,
+    STOP_STREAM                      = 0x0000,
+    START_HIGH_SPEED_REALTIME_STREAM = 0x0002,
+    START_HIGH_SPEED_BUFFERED_STREAM = 0x0003,
+    START_MULTI_UNIT_STREAMING       = 0x0004,
+    RESET_THRESHOLD_LATCH            = 0x0041,
+    SET_SOFTWARE_BIAS                = 0x0042
+};
+
+struct RTDRequest
+{
+    constexpr RTDRequest(RTDCommand command) : RTDRequest(command, 0)
+    {
+    }
+
+    constexpr RTDRequest(RTDCommand command, uint32_t sample_count)
+    : header(static_cast<uint16_t>(RTDCommand::HEADER))
+    , command(static_cast<uint16_t>(command))
+    , sample_count(sample_count)
+    {
+    }
+
+    uint16_t header;
+    uint16_t command;
+    uint32_t sample_count = 0;
+};
+
+struct RTDResponse
+{
+    uint32_t rdt_package_sequence_index;
+    uint32_t ft_internal_sequence_index;
+    uint32_t status;
+    int32_t fx;
+    int32_t fy;
+    int32_t fz;
+    int32_t tx;
+    int32_t ty;
+    int32_t tz;
+};
+
+constexpr std::size_t RTD_REQUEST_SIZE = 8u;
+constexpr std::size_t RTD_RESPONSE_SIZE = 36u;
+constexpr std::size_t RTD_MAX_DATAGRAM_SIZE = 2048u;
+
+// std::byteswap is C++23; the shift patterns compile to bswap / rev, and vectorize in loops.
+template<typename T>
+constexpr T byteSwap(T value)
+{
+    static_assert(std::is_unsigned_v<T>, "byteSwap works on unsigned integers");
+    if constexpr(sizeof(T) == 1u)
+        return value;
+    else if constexpr(sizeof(T) == 2u)
+        return static_cast<T>(value >> 8 | value << 8);
+    else if constexpr(sizeof(T) == 4u)
+        return (value >> 24) | (value >> 8 & 0x0000ff00u) | (value << 8 & 0x00ff0000u) | (value << 24);
+    else
+        return static_cast<T>(byteSwap(static_cast<uint32_t>(value))) << 32 | byteSwap(static_cast<uint32_t>(value >> 32));
+}
+
+template<typename T>
+constexpr T toBigEndian(T value)
+{
+    if constexpr(std::endian::native == std::endian::little)
+        return byteSwap(value);
+    else
+        return value;
+}
+
+template<typename Member>
+struct MemberTraits;
+
+template<typename Class, typename Type>
+struct MemberTraits<Type Class::*>
+{
+    typedef Class ClassType;
+    typedef Type ValueType;
+};
+
+// A big-endian integer on the wire at Offset, stored in Member.
+template<auto Member, std::size_t Offset>
+struct WireField
+{
+    typedef typename MemberTraits<decltype(Member)>::ValueType ValueType;
+    typedef std::make_unsigned_t<ValueType> Bits;
+
+    static_assert(std::is_integral_v<ValueType>, "Wire fields are integers");
+
+    static constexpr auto MEMBER = Member;
+    static constexpr std::size_t OFFSET = Offset;
+    static constexpr std::size_t SIZE = sizeof(ValueType);
+
+    template<typename Struct>
+    static constexpr void encode(const Struct &value, unsigned char *out)
+    {
+        auto bytes = std::bit_cast<std::array<unsigned char, SIZE>>(toBigEndian(static_cast<Bits>(value.*Member)));
+        std::copy(bytes.begin(), bytes.end(), out + OFFSET);
+    }
+
+    template<typename Struct>
+    static constexpr void decode(const unsigned char *in, Struct &value)
+    {
+        std::array<unsigned char, SIZE> bytes;
+        std::copy(in + OFFSET, in + OFFSET + SIZE, bytes.begin());
+        value.*Member = static_cast<ValueType>(toBigEndian(std::bit_cast<Bits>(bytes)));
+    }
+};
+
+// Wire format of Struct: Fields listed in offset order, packed back to back into exactly Size bytes.
+template<typename Struct, std::size_t Size, typename... Fields>
+struct WireLayout
+{
+    static constexpr std::size_t SIZE = Size;
+
+    static constexpr bool isPacked()
+    {
+        constexpr std::array<std::size_t, sizeof...(Fields)> offsets{Fields::OFFSET...};
+        constexpr std::array<std::size_t, sizeof...(Fields)> sizes{Fields::SIZE...};
+        std::size_t end = 0;
+        for(std::size_t i = 0; i < offsets.size(); i++)
+        {
+            if(offsets[i] != end)
+                return false;
+            end += sizes[i];
+        }
+        return end == Size;
+    }
+
+    static_assert(isPacked(), "Wire fields must be listed in order and cover the record without gaps or overlap");
+
+    // True if Struct's memory layout is the wire layout in native byte order, so records can be copied verbatim and
+    // only need their words swapped.
+    static constexpr bool mirrorsMemory()
+    {
+        if constexpr(sizeof(Struct) != Size || !std::is_trivially_copyable_v<Struct> || !std::is_default_constructible_v<Struct>)
+        {
+            return false;
+        }
+        else
+        {
+            Struct probe{};
+            ((probe.*Fields::MEMBER = static_cast<typename Fields::ValueType>(Fields::OFFSET + 1u)), ...);
+            auto bytes = std::bit_cast<std::array<unsigned char, Size>>(probe);
+            return (atOffset<Fields>(bytes) && ...);
+        }
+    }
+
+    static constexpr std::array<unsigned char, Size> encode(const Struct &value)
+    {
+        std::array<unsigned char, Size> out{};
+        (Fields::encode(value, out.data()), ...);
+        return out;
+    }
+
+    static constexpr void decode(const unsigned char *in, Struct &value)
+    {
+        (Fields::decode(in, value), ...);
+    }
+
+private:
+    template<typename Field>
+    static constexpr bool atOffset(const std::array<unsigned char, Size> &bytes)
+    {
+        std::array<unsigned char, Field::SIZE> field;
+        std::copy(bytes.begin() + Field::OFFSET, bytes.begin() + Field::OFFSET + Field::SIZE, field.begin());
+        return std::bit_cast<typename Field::ValueType>(field) == static_cast<typename Field::ValueType>(Field::OFFSET + 1u);
+    }
+};
+
+// Encoding and decoding of RDT requests and responses, generated from their layouts. Everything but the batch decode
+// is constexpr, so the encodings are checked at compile time below.
+class RdtCodec
+{
+public:
+    typedef WireLayout<RTDRequest, RTD_REQUEST_SIZE,
+                       WireField<&RTDRequest::header, 0>,
+                       WireField<&RTDRequest::command, 2>,
+                       WireField<&RTDRequest::sample_count, 4>> RequestLayout;
+
+    typedef WireLayout<RTDResponse, RTD_RESPONSE_SIZE,
+                       WireField<&RTDResponse::rdt_package_sequence_index, 0>,
+                       WireField<&RTDResponse::ft_internal_sequence_index, 4>,
+                       WireField<&RTDResponse::status, 8>,
+                       WireField<&RTDResponse::fx, 12>,
+                       WireField<&RTDResponse::fy, 16>,
+                       WireField<&RTDResponse::fz, 20>,
+                       WireField<&RTDResponse::tx, 24>,
+                       WireField<&RTDResponse::ty, 28>,
+                       WireField<&RTDResponse::tz, 32>> ResponseLayout;
+
+    static constexpr std::array<unsigned char, RTD_REQUEST_SIZE> encode(const RTDRequest &request)
+    {
+        return RequestLayout::encode(request);
+    }
+
+    static constexpr bool isRequestCommand(uint16_t command)
+    {
+        switch(static_cast<RTDCommand>(command))
+        {
+        case RTDCommand::STOP_STREAM:
+        case RTDCommand::START_HIGH_SPEED_REALTIME_STREAM:
+        case RTDCommand::START_HIGH_SPEED_BUFFERED_STREAM:
+        case RTDCommand::START_MULTI_UNIT_STREAMING:
+        case RTDCommand::RESET_THRESHOLD_LATCH:
+        case RTDCommand::SET_SOFTWARE_BIAS:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Empty for datagrams that are too short, lack the 0x1234 header or carry an unknown command.
+    static constexpr std::optional<RTDRequest> decodeRequest(std::span<const unsigned char> datagram)
+    {
+        if(datagram.size() < RTD_REQUEST_SIZE)
+            return std::nullopt;
+        RTDRequest request(RTDCommand::STOP_STREAM);
+        RequestLayout::decode(datagram.data(), request);
+        if(request.header != static_cast<uint16_t>(RTDCommand::HEADER) || !isRequestCommand(request.command))
+            return std::nullopt;
+        return request;
+    }
+
+    static constexpr std::array<unsigned char, RTD_RESPONSE_SIZE> encode(const RTDResponse &response)
+    {
+        return ResponseLayout::encode(response);
+    }
+
+    static constexpr RTDResponse decode(const unsigned char *record)
+    {
+        RTDResponse response{};
+        ResponseLayout::decode(record, response);
+        return response;
+    }
+
+    // Decodes every whole record of payload into responses, which must have room for payload.size() /
+    // RTD_RESPONSE_SIZE of them, and returns how many there were. The records are copied verbatim and byte-swapped
+    // as one flat run of words with SIMD shuffles.
+    static std::size_t decode(std::span<const unsigned char> payload, RTDResponse *responses);
+};
+
+static_assert(sizeof(RTDResponse) == RTD_RESPONSE_SIZE, "RTDResponse must mirror the 36-byte wire record");
+static_assert(RdtCodec::ResponseLayout::mirrorsMemory(), "RTDResponse members must be declared in wire order");
+
+static_assert(RdtCodec::encode(RTDRequest(RTDCommand::STOP_STREAM)) ==
+              std::array<unsigned char, RTD_REQUEST_SIZE>{0x12, 0x34, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00});
+static_assert(RdtCodec::encode(RTDRequest(RTDCommand::START_HIGH_SPEED_REALTIME_STREAM)) ==
+              std::array<unsigned char, RTD_REQUEST_SIZE>{0x12, 0x34, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00});
+static_assert(RdtCodec::encode(RTDRequest(RTDCommand::START_HIGH_SPEED_BUFFERED_STREAM, 0x01020304u)) ==
+              std::array<unsigned char, RTD_REQUEST_SIZE>{0x12, 0x34, 0x00, 0x03, 0x01, 0x02, 0x03, 0x04});
+static_assert(RdtCodec::encode(RTDRequest(RTDCommand::START_MULTI_UNIT_STREAMING, 10u)) ==
+              std::array<unsigned char, RTD_REQUEST_SIZE>{0x12, 0x34, 0x00, 0x04, 0x00, 0x00, 0x00, 0x0a});
+static_assert(RdtCodec::encode(RTDRequest(RTDCommand::RESET_THRESHOLD_LATCH)) ==
+              std::array<unsigned char, RTD_REQUEST_SIZE>{0x12, 0x34, 0x00, 0x41, 0x00, 0x00, 0x00, 0x00});
+static_assert(RdtCodec::encode(RTDRequest(RTDCommand::SET_SOFTWARE_BIAS)) ==
+              std::array<unsigned char, RTD_REQUEST_SIZE>{0x12, 0x34, 0x00, 0x42, 0x00, 0x00, 0x00, 0x00});
+static_assert(RdtCodec::decodeRequest(RdtCodec::encode(RTDRequest(RTDCommand::SET_SOFTWARE_BIAS)))->command ==
+              static_cast<uint16_t>(RTDCommand::SET_SOFTWARE_BIAS));
+static_assert(!RdtCodec::decodeRequest(std::array<unsigned char, RTD_REQUEST_SIZE>{0x12, 0x34, 0x00, 0x07}).has_value());
+static_assert(RdtCodec::decode(RdtCodec::encode(RTDResponse{1u, 2u, 3u, -4, 5, -6, 7, -8, 2147483647}).data()).tz == 2147483647);
+static_assert(RdtCodec::decode(RdtCodec::encode(RTDResponse{1u, 2u, 3u, -4, 5, -6, 7, -8, 9}).data()).fx == -4);
+}
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_RDTRECORDER_H
+#define ESTIMATION_SENSOR_INTERFACE_RDTRECORDER_H
+
+#include "sensor_interface/spscqueue.h"
+#include "sensor_interface/sensorsample.h"
+#include "sensor_interface/netboxrdtclient.h"
+
+#include <span>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace estimation::sensor_interface {
+class SensorController;
+
+struct RecordedResponse
+{
+    int64_t received_ns;
+    RTDResponse response;
+    uint32_t unit;
+};
+
+static_assert(sizeof(RecordedResponse) == 48u, "Recording layout is part of the file format");
+
+struct RecordingHeader
+{
+    static constexpr uint64_t MAGIC = 0x313054445258424eull; // "NBXRDT01" in file byte order
+
+    uint64_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;
+    uint64_t count;
+    uint64_t overflowed;
+    uint8_t reserved[24];
+};
+
+static_assert(sizeof(RecordingHeader) == 64u, "Recording layout is part of the file format");
+
+// Carries raw records from receive threads to one writer thread. Producers are serialized, so controllers serviced
+// by different threads may feed the same queue; after close() their records are dropped. Listeners share it with
+// the writer through a shared_ptr, so either may be destroyed first.
+class RecordQueue
+{
+public:
+    explicit RecordQueue(std::size_t capacity);
+
+    void push(std::span<const RTDResponse> batch, SampleTime received, uint32_t unit);
+    // Consumer only.
+    bool tryPop(RecordedResponse &record);
+    RecordedResponse *front();
+    void pop();
+
+    void close();
+    // Records lost because the queue was full.
+    uint64_t dropped() const;
+
+private:
+    std::mutex m_producer_lock;
+    bool m_open;
+    SpscQueue<RecordedResponse> m_queue;
+    std::atomic<uint64_t> m_dropped;
+};
+
+// Appends raw records to a preallocated, memory-mapped file. record() only enqueues; a background thread copies
+// into the mapping so the receive path never waits on page faults or disk I/O. One recorder may be attached to
+// several controllers, also ones serviced by different threads.
+class RdtRecorder
+{
+public:
+    RdtRecorder(const std::string &path, uint64_t capacity, std::size_t queue_capacity = 1u << 16);
+    ~RdtRecorder();
+
+    RdtRecorder(const RdtRecorder &) = delete;
+    RdtRecorder &operator=(const RdtRecorder &) = delete;
+
+    // The recorder may be destroyed before the controller; the listener then drops its records.
+    void attach(SensorController &controller, uint32_t unit = 0);
+    void record(std::span<const RTDResponse> batch, SampleTime received, uint32_t unit = 0);
+
+    uint64_t recorded() const;
+    // Records lost because the queue or the file was full.
+    uint64_t dropped() const;
+
+    void close();
+
+private:
+    int m_fd;
+    uint64_t m_capacity;
+    RecordingHeader *m_header;
+    RecordedResponse *m_records;
+    std::size_t m_mapping_size;
+    std::shared_ptr<RecordQueue> m_queue;
+    std::atomic<bool> m_running;
+    std::atomic<uint64_t> m_recorded;
+    std::atomic<uint64_t> m_dropped;
+    std::thread m_writer;
+
+    void write();
+};
+
+// Memory-maps a recording for sequential scans or for replay through a SensorController.
+class RdtRecordingReader
+{
+public:
+    explicit RdtRecordingReader(const std::string &path);
+    ~RdtRecordingReader();
+
+    RdtRecordingReader(const RdtRecordingReader &) = delete;
+    RdtRecordingReader &operator=(const RdtRecordingReader &) = delete;
+
+    std::span<const RecordedResponse> records() const;
+
+    // Feeds one unit's records to the controller, batched per received datagram. A speed of 0 replays as fast as
+    // possible; 1.0 reproduces the recorded timing.
+    void replay(SensorController &controller, uint32_t unit = 0, double speed = 0.0) const;
+
+private:
+    int m_fd;
+    const void *m_mapping;
+    std::size_t m_mapping_size;
+    const RecordingHeader *m_header;
+};
+}
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_REMOTESAMPLESTREAM_H
+#define ESTIMATION_SENSOR_INTERFACE_REMOTESAMPLESTREAM_H
+
+#include "sensor_interface/seqlock.h"
+#include "sensor_interface/sensorsample.h"
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <condition_variable>
+
+namespace estimation::sensor_interface {
+class SensorController;
+
+// Wire format of a republished batch, all fields little-endian. The header is followed by count records.
+//   header: magic u32, version u8, flags u8, count u16, stream id u32, datagram sequence u64,
+//           first sample sequence u64, first sample timestamp i64 (ns since the epoch)
+//   record: sequence delta u16, timestamp offset u32 (ns), six load channels f32 (N, Nm)
+struct RemoteStreamFormat
+{
+    static constexpr uint32_t MAGIC = 0x5253424eu;
+    static constexpr uint8_t VERSION = 1u;
+    static constexpr uint8_t FILTERED = 0x01u;
+    static constexpr std::size_t HEADER_SIZE = 36u;
+    static constexpr std::size_t RECORD_SIZE = 30u;
+    // Largest batch that still fits an unfragmented datagram on a 1500 byte MTU.
+    static constexpr std::size_t MAX_BATCH_SIZE = (1472u - HEADER_SIZE) / RECORD_SIZE;
+    static constexpr std::size_t MAX_DATAGRAM_SIZE = HEADER_SIZE + MAX_BATCH_SIZE * RECORD_SIZE;
+};
+
+struct RemoteStreamSettings
+{
+    // Multicast group or unicast host to send to; subscribers join the group, or bind to this address if unicast.
+    std::string address = "239.255.42.1";
+    uint16_t port = 49200;
+    // Local interface for multicast traffic; empty lets the routing table decide.
+    std::string interface_address;
+    // Tags every datagram so several publishers can share a group; subscribers drop other streams.
+    uint32_t stream_id = 0;
+    // Samples per datagram, clamped to RemoteStreamFormat::MAX_BATCH_SIZE.
+    std::size_t batch_size = 16u;
+    // A partial batch is sent once its oldest sample has waited this long.
+    std::chrono::microseconds latency_bound{2000};
+    int multicast_ttl = 1;
+    bool multicast_loopback = true;
+    // Republish the filter pipeline's output instead of the calibrated samples.
+    bool filtered = false;
+};
+
+struct RemoteStreamStatistics
+{
+    uint64_t datagrams = 0;
+    uint64_t samples = 0;
+    // Publisher: datagrams the socket refused. Subscriber: datagrams missing from the sequence.
+    uint64_t dropped = 0;
+    // Subscriber only: datagrams that were not a valid batch of this stream.
+    uint64_t malformed = 0;
+};
+
+// Batches one SensorController's calibrated samples into compact datagrams for hosts that must not open their own
+// RDT session. Samples are encoded on the receive thread; a batch goes out when it is full or when a small flush
+// thread finds it older than the latency bound. Sends never block the receive thread.
+class RemoteSamplePublisher
+{
+public:
+    RemoteSamplePublisher(SensorController &controller, const RemoteStreamSettings &settings = {});
+    ~RemoteSamplePublisher();
+
+    RemoteSamplePublisher(const RemoteSamplePublisher &) = delete;
+    RemoteSamplePublisher &operator=(const RemoteSamplePublisher &) = delete;
+
+    // Sends the pending partial batch now.
+    void flush();
+    RemoteStreamStatistics statistics() const;
+
+private:
+    struct Sender;
+
+    std::shared_ptr<Sender> m_sender;
+    std::thread m_flush_thread;
+};
+
+// Receives a RemoteSamplePublisher's stream. Samples keep the publisher's sequence numbers and timestamps; their
+// latency is measured from that timestamp, so it only means something between hosts with synchronized clocks.
+class RemoteSampleSubscriber
+{
+public:
+    typedef std::function<void(const SensorSample &sample)> SampleListener;
+
+    explicit RemoteSampleSubscriber(const RemoteStreamSettings &settings = {});
+    ~RemoteSampleSubscriber();
+
+    RemoteSampleSubscriber(const RemoteSampleSubscriber &) = delete;
+    RemoteSampleSubscriber &operator=(const RemoteSampleSubscriber &) = delete;
+
+    // Called on the subscriber's receive thread for every sample, in order.
+    void addSampleListener(SampleListener listener);
+
+    bool isFiltered() const;
+    SensorSample latestSample() const;
+    std::optional<SensorSample> waitForNext(uint64_t last_sequence, std::chrono::nanoseconds timeout);
+
+    RemoteStreamStatistics statistics() const;
+
+private:
+    RemoteStreamSettings m_settings;
+    int m_fd;
+
+    std::mutex m_listener_lock;
+    std::vector<SampleListener> m_listeners;
+
+    SeqLock<SensorSample> m_latest_sample;
+    std::mutex m_wait_lock;
+    std::atomic<uint32_t> m_waiters;
+    std::condition_variable m_sample_published;
+
+    std::atomic<bool> m_filtered;
+    std::atomic<uint64_t> m_datagrams;
+    std::atomic<uint64_t> m_samples;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_malformed;
+    uint64_t m_next_datagram;
+
+    std::atomic<bool> m_running;
+    std::thread m_receive_thread;
+
+    void receiveLoop();
+    void receiveDatagram(const unsigned char *data, std::size_t size);
+};
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_RESAMPLER_H
+#define ESTIMATION_SENSOR_INTERFACE_RESAMPLER_H
+
+#include "sensor_interface/sensorsample.h"
+
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <optional>
+#include <functional>
+
+#include <Eigen/Core>
+
+namespace estimation::sensor_interface {
+class SensorController;
+
+enum class Interpolation
+{
+    LINEAR,
+    // Cubic Hermite with finite-difference tangents; passes through every sample and adapts to uneven spacing.
+    CUBIC
+};
+
+struct ResamplerSettings
+{
+    Interpolation interpolation = Interpolation::LINEAR;
+    // Most recent stream samples kept for lookups.
+    std::size_t capacity = 1024u;
+    // Queries up to this far past the newest sample are extrapolated from the last two samples instead of failing.
+    std::chrono::microseconds max_extrapolation{2000};
+};
+
+struct ResampledSample
+{
+    SampleTime timestamp;
+    std::array<double, 6> load{};
+    // Newest stream sample at or before timestamp.
+    uint64_t sequence = 0;
+    // timestamp lies past the newest received sample, so load is a prediction.
+    bool extrapolated = false;
+
+    Eigen::Vector3d force() const
+    {
+        return {load[0], load[1], load[2]};
+    }
+
+    Eigen::Vector3d torque() const
+    {
+        return {load[3], load[4], load[5]};
+    }
+};
+
+// Answers "what was the load at time t" on the stream's receive timestamps. It copies new samples out of the
+// controller's lock-free history on demand, so the receive thread is never blocked, and finds the bracketing samples
+// by binary search. Records of a buffered datagram are spread over the sample period by SensorController::ingest(),
+// so both interpolations see every sample at its own time.
+class Resampler
+{
+public:
+    // Called once per output tick with the tick's time and the load at it, or nothing if the stream has no sample
+    // close enough.
+    typedef std::function<void(SampleTime tick, const std::optional<ResampledSample> &sample)> OutputListener;
+
+    explicit Resampler(const SensorController &controller, const ResamplerSettings &settings = {});
+    ~Resampler();
+
+    Resampler(const Resampler &) = delete;
+    Resampler &operator=(const Resampler &) = delete;
+
+    // Empty if time is older than the window or further past the newest sample than max_extrapolation.
+    std::optional<ResampledSample> sampleAt(SampleTime time);
+
+    // Starts a thread that calls listener every period on an exact grid of absolute deadlines, with the load at
+    // tick - delay. A delay of a sample period or two plus the stream latency keeps the ticks interpolated.
+    void startOutput(std::chrono::nanoseconds period, OutputListener listener,
+                     std::chrono::nanoseconds delay = std::chrono::nanoseconds::zero());
+    void stopOutput();
+
+    // Output ticks that found no sample, and ticks whose deadline had already passed when the thread woke up.
+    uint64_t missedTicks() const;
+    uint64_t lateTicks() const;
+
+private:
+    const SensorController &m_controller;
+    ResamplerSettings m_settings;
+
+    std::mutex m_lock;
+    std::vector<SensorSample> m_window;
+    std::size_t m_first;
+    std::size_t m_size;
+    uint64_t m_cursor;
+    std::vector<SensorSample> m_scratch;
+
+    std::thread m_output_thread;
+    std::atomic<bool> m_output_running;
+    std::atomic<uint64_t> m_missed_ticks;
+    std::atomic<uint64_t> m_late_ticks;
+
+    void refresh();
+    const SensorSample &at(std::size_t index) const;
+};
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_SAMPLEHISTORY_H
+#define ESTIMATION_SENSOR_INTERFACE_SAMPLEHISTORY_H
+
+#include "sensor_interface/sensorsample.h"
+
+#include <span>
+#include <atomic>
+#include <memory>
+
+namespace estimation::sensor_interface {
+// Fixed-capacity ring of the most recent samples. One thread pushes, any number of threads read without locking;
+// readers that fall more than capacity() samples behind skip ahead to the oldest sample still held.
+class SampleHistory
+{
+public:
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> version{0};
+        SensorSample sample;
+    };
+
+    explicit SampleHistory(std::size_t capacity);
+    // Ring over caller-owned storage, e.g. a shared-memory segment: capacity is a power of two, slots start zeroed
+    // and head starts at 1. The storage must outlive the history.
+    SampleHistory(Slot *slots, std::size_t capacity, std::atomic<uint64_t> *head);
+
+    SampleHistory(const SampleHistory &) = delete;
+    SampleHistory &operator=(const SampleHistory &) = delete;
+
+    std::size_t capacity() const;
+
+    // Sequence number that the next pushed sample will get; push() overwrites the sample's own sequence with it. Sequences start at 1 so that 0 can mean "nothing seen yet".
+    uint64_t nextSequence() const;
+
+    uint64_t push(const SensorSample &sample);
+
+    // Copies samples with sequence >= cursor into samples, oldest first, and advances cursor past the last one copied.
+    std::size_t readSince(uint64_t &cursor, std::span<SensorSample> samples) const;
+
+private:
+    std::size_t m_mask;
+    std::unique_ptr<Slot[]> m_storage;
+    Slot *m_slots;
+    std::atomic<uint64_t> *m_head;
+    alignas(64) std::atomic<uint64_t> m_local_head;
+
+    bool readSlot(uint64_t sequence, SensorSample &sample) const;
+};
+}
+
+#endif
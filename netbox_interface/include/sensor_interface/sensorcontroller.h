@@ -1,39 +1,87 @@
 #ifndef ESTIMATION_SENSOR_INTERFACE_SENSORCONTROLLER_H
 #define ESTIMATION_SENSOR_INTERFACE_SENSORCONTROLLER_H
 
+#include "sensor_interface/seqlock.h"
+#include "sensor_interface/calibration.h"
+#include "sensor_interface/asyncdispatcher.h"
+#include "sensor_interface/filterpipeline.h"
+#include "sensor_interface/windowstatistics.h"
+#include "sensor_interface/samplehistory.h"
 #include "sensor_interface/netboxrdtclient.h"
 
 #include <mutex>
 #include <memory>
 #include <string>
 #include <thread>
+#include <optional>
+#include <coroutine>
 #include <shared_mutex>
+#include <condition_variable>
 
 #include <Eigen/Core>
 
 namespace estimation::sensor_interface {
 class SensorController
 {
-    struct SensorSnapshot
+public:
+    typedef std::function<void(const Eigen::Vector3d &force, const Eigen::Vector3d &torque)> SensorReadingListener;
+    typedef std::function<void(const SensorSample &sample)> SensorSampleListener;
+    typedef FTSensorBatchListener RawBatchListener;
+    typedef NetboxConnectionListener ConnectionListener;
+
+    static constexpr std::size_t DEFAULT_HISTORY_CAPACITY = 1u << 16;
+
+    // Awaitable returned by nextSample(). Suspended coroutines are resumed without locking, usually on the thread that
+    // publishes the sample (the receive thread, or the caller of poll()). A coroutine that suspends just as a sample
+    // lands takes over the waiting list instead, so the others may then be resumed on that coroutine's thread before
+    // it continues. Each receives the latest sample newer than the sequence it waited on. Coroutines still suspended
+    // when the controller is destroyed are never resumed.
+    class SampleAwaiter
     {
-        double fx;
-        double fy;
-        double fz;
-        double tx;
-        double ty;
-        double tz;
+    public:
+        bool await_ready();
+        bool await_suspend(std::coroutine_handle<> handle);
+        SensorSample await_resume() const;
+
+    private:
+        friend class SensorController;
+
+        SampleAwaiter(SensorController &controller, uint64_t last_sequence);
+
+        SensorController &m_controller;
+        uint64_t m_last_sequence;
+        std::coroutine_handle<> m_handle;
+        SampleAwaiter *m_next;
+        SensorSample m_sample;
     };
 
-public:
-    typedef std::function<void(const Eigen::Vector3d &force, const Eigen::Vector3d &torque)> SensorReadingListener;
+    SensorController(const std::string &hostname, uint32_t port, const NetboxStreamSettings &settings = {},
+                     std::size_t history_capacity = DEFAULT_HISTORY_CAPACITY);
+
+    // Creates a controller without its own Netbox connection; samples arrive through attach() or ingest().
+    explicit SensorController(std::size_t history_capacity = DEFAULT_HISTORY_CAPACITY);
+    ~SensorController();
 
-    SensorController(const std::string &hostname, uint32_t port);
+    // Registers with the client's listeners, so it must happen before the client's stream is opened, and the client
+    // must stop streaming before this controller is destroyed.
+    void attach(NetboxRdtClient &client, uint32_t unit = 0);
+    void ingest(std::span<const RTDResponse> batch, SampleTime received = std::chrono::system_clock::now());
 
+    // Records of a buffered datagram arrive together, so ingest() stamps each one back from the receive time by its
+    // distance in ft_internal_sequence_index to the datagram's last record. The spacing is 1 / rate once the
+    // Netbox's RDT output rate is set here, and is estimated from consecutive datagrams while it is 0 (the default).
+    void setSampleRate(double rate);
+
+    // True while the attached Netbox delivers data; the client's stall watchdog clears it and restarts the stream.
     bool hasConnectedSensor();
+    void addConnectionListener(ConnectionListener listener);
 
     void setCalibrationBias(const Eigen::Vector3d &force_bias, const Eigen::Vector3d &torque_bias);
 
     void setCountPerForceTorque(uint32_t fcount, uint32_t tcount);
+    void setCalibrationMatrix(const Matrix6d &counts_to_wrench);
+    void setToolTransform(const Eigen::Isometry3d &tool_from_sensor);
+    Calibration calibration() const;
 
     Eigen::Vector3d forceBias() const;
     Eigen::Vector3d torqueBias() const;
@@ -41,24 +89,87 @@ public:
     std::pair<Eigen::Vector3d, Eigen::Vector3d> currentRawLoad();
     std::pair<Eigen::Vector3d, Eigen::Vector3d> currentUnbiasedLoad();
 
+    // Replaces the filter pipeline run once per sample on the receive thread; an empty pipeline disables the
+    // filtered stream. Filtered samples keep the sequence and timestamp of the raw sample that completed them.
+    void setFilterPipeline(const FilterPipeline &pipeline);
+
+    // Maintains sliding-window statistics of the calibrated samples over each given window length (in samples).
+    void setStatisticsWindows(std::span<const std::size_t> windows);
+    // Lock-free; window is an index into the lengths passed to setStatisticsWindows().
+    WindowStatisticsSnapshot windowStatistics(std::size_t window) const;
+
+    SensorSample latestSample() const;
+    SensorSample latestFilteredSample() const;
+    std::optional<SensorSample> waitForNext(uint64_t last_sequence, std::chrono::nanoseconds timeout);
+
+    // co_await controller.nextSample() yields the first sample published after the call; the overload yields the
+    // latest sample with a sequence above last_sequence.
+    SampleAwaiter nextSample();
+    SampleAwaiter nextSample(uint64_t last_sequence);
+
+#ifdef NETBOX_LINUX_SOCKET
+    // For controllers opened with NetboxStreamSettings::receive_thread = false: the socket to watch for readability
+    // and a non-blocking drain that dispatches everything received so far.
+    int nativeHandle() const;
+    std::size_t poll();
+#endif
+
     void addSensorReadingReceivedListener(SensorReadingListener listener);
+    void addSensorSampleListener(SensorSampleListener listener);
+    void addFilteredSampleListener(SensorSampleListener listener);
+    void addRawBatchListener(RawBatchListener listener);
+
+    // Listeners called from their own bounded queue instead of the receive thread. Returns the subscriber id used
+    // for subscriberStatistics().
+    std::size_t addAsyncSampleListener(SensorSampleListener listener, const AsyncListenerOptions &options = {});
+    std::size_t addAsyncFilteredSampleListener(SensorSampleListener listener, const AsyncListenerOptions &options = {});
+    SubscriberStatistics subscriberStatistics(std::size_t subscriber) const;
+
+    StreamStatisticsSnapshot streamStatistics() const;
+
+    const SampleHistory &sampleHistory() const;
+    std::size_t readSamplesSince(uint64_t &sequence, std::span<SensorSample> samples) const;
 
 private:
     uint32_t m_port;
     std::string m_hostname;
+    NetboxStreamSettings m_settings;
     std::mutex m_listener_lock;
+    std::atomic<int64_t> m_nominal_period;
+    double m_estimated_period;
+    SampleTime m_period_received;
+    std::optional<uint32_t> m_period_index;
     Eigen::Vector3d m_force_bias;
     Eigen::Vector3d m_torque_bias;
     std::shared_mutex m_interface_lock;
     std::atomic<bool> m_sensor_connected;
     mutable std::shared_mutex m_bias_lock;
-    std::atomic<uint32_t> m_count_per_force;
-    std::atomic<uint32_t> m_count_per_torque;
-    std::atomic<SensorSnapshot> m_sensor_load_snapshot;
+    Calibration m_calibration;
+    Eigen::Isometry3d m_tool_transform;
+    mutable std::shared_mutex m_calibration_lock;
+    std::mutex m_wait_lock;
+    std::atomic<uint32_t> m_waiters;
+    std::condition_variable m_sample_published;
+    std::atomic<SampleAwaiter*> m_awaiters;
+    SeqLock<SensorSample> m_latest_sample;
+    SeqLock<SensorSample> m_latest_filtered_sample;
+    FilterPipeline m_filter;
+    WindowStatistics m_window_statistics;
+    SampleHistory m_history;
+    std::atomic<const StreamStatistics*> m_statistics;
+    AsyncDispatcher m_dispatcher;
     std::unique_ptr<NetboxRdtClient> m_netbox_rdt;
     std::vector<SensorReadingListener> m_listeners;
-
-    void sensorLoadReceived(int32_t fx, int32_t fy, int32_t fz, int32_t tx, int32_t ty, int32_t tz);
+    std::vector<SensorSampleListener> m_sample_listeners;
+    std::vector<SensorSampleListener> m_filtered_listeners;
+    std::vector<RawBatchListener> m_raw_listeners;
+    std::vector<ConnectionListener> m_connection_listeners;
+
+    void notifyWaiters();
+    void connectionChanged(bool connected);
+    void resumeAwaiters(SampleAwaiter *awaiters, SampleAwaiter *self = nullptr);
+    SampleTime::duration samplePeriod(std::span<const RTDResponse> batch, SampleTime received);
+    void sensorLoadReceived(SampleTime timestamp, SampleTime received, SampleTime dispatched, const std::array<double, 6> &load);
 
     void startSensorInterface();
 };
@@ -0,0 +1,67 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_SENSORHUB_H
+#define ESTIMATION_SENSOR_INTERFACE_SENSORHUB_H
+
+#include "sensor_interface/sensorcontroller.h"
+#include "sensor_interface/netboxrdtclient.h"
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace estimation::sensor_interface {
+// Services many Netbox connections from a small, fixed pool of epoll-driven I/O threads.
+// Each sensor keeps its own SensorController; sensors are spread round-robin over the I/O threads, which also run
+// every connection's stall watchdog.
+class SensorHub
+{
+public:
+    explicit SensorHub(std::size_t io_threads = 1u);
+    ~SensorHub();
+
+    SensorHub(const SensorHub &) = delete;
+    SensorHub &operator=(const SensorHub &) = delete;
+
+    SensorController &addSensor(const std::string &hostname, uint16_t port, const NetboxStreamSettings &settings = {},
+                                std::size_t history_capacity = SensorController::DEFAULT_HISTORY_CAPACITY);
+
+    // Streams START_MULTI_UNIT_STREAMING over one connection and returns one controller per transducer.
+    std::vector<SensorController*> addMultiUnitSensor(const std::string &hostname, uint16_t port, uint32_t unit_count,
+                                                      NetboxStreamSettings settings = {},
+                                                      std::size_t history_capacity = SensorController::DEFAULT_HISTORY_CAPACITY);
+
+    std::size_t sensorCount() const;
+    SensorController &sensor(std::size_t index);
+
+    void stop();
+
+private:
+    struct Sensor
+    {
+        NetboxRdtClient client;
+        std::size_t io_thread = 0u;
+        std::vector<std::unique_ptr<SensorController>> controllers;
+    };
+
+    struct IoThread
+    {
+        int epoll_fd = -1;
+        int wake_fd = -1;
+        std::thread thread;
+    };
+
+    std::atomic<bool> m_running;
+    mutable std::mutex m_sensor_lock;
+    std::vector<IoThread> m_io_threads;
+    std::vector<std::unique_ptr<Sensor>> m_sensors;
+    std::vector<SensorController*> m_controllers;
+
+    Sensor &openSensor(const std::string &hostname, uint16_t port, const NetboxStreamSettings &settings,
+                       std::size_t history_capacity);
+    void run(IoThread &io_thread);
+};
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_SENSORSAMPLE_H
+#define ESTIMATION_SENSOR_INTERFACE_SENSORSAMPLE_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include <Eigen/Core>
+
+namespace estimation::sensor_interface {
+typedef std::chrono::system_clock::time_point SampleTime;
+
+struct SensorSample
+{
+    uint64_t sequence = 0;
+    // Receive time of the datagram, moved back by the record's position in a buffered datagram.
+    SampleTime timestamp;
+    // Time from socket receive to delivery on the controller's dispatch path.
+    std::chrono::nanoseconds latency{0};
+    std::array<double, 6> load{};
+
+    Eigen::Vector3d force() const
+    {
+        return {load[0], load[1], load[2]};
+    }
+
+    Eigen::Vector3d torque() const
+    {
+        return {load[3], load[4], load[5]};
+    }
+};
+}
+
+#endif
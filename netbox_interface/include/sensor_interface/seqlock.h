@@ -0,0 +1,67 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_SEQLOCK_H
+#define ESTIMATION_SENSOR_INTERFACE_SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace estimation::sensor_interface {
+// Single-writer sequence lock. Readers never block the writer; they retry if a store overlapped their copy.
+template<typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock values are copied with memcpy");
+
+public:
+    SeqLock()
+    : m_version(0u)
+    , m_value{}
+    {
+    }
+
+    explicit SeqLock(const T &value)
+    : m_version(0u)
+    , m_value(value)
+    {
+    }
+
+    void store(const T &value)
+    {
+        auto version = m_version.load(std::memory_order_relaxed);
+        m_version.store(version + 1u, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&m_value, &value, sizeof(T));
+        m_version.store(version + 2u, std::memory_order_release);
+    }
+
+    bool tryLoad(T &value) const
+    {
+        auto before = m_version.load(std::memory_order_acquire);
+        if(before & 1u)
+            return false;
+        std::memcpy(&value, &m_value, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return m_version.load(std::memory_order_relaxed) == before;
+    }
+
+    T load() const
+    {
+        T value;
+        while(!tryLoad(value))
+            ;
+        return value;
+    }
+
+    uint64_t version() const
+    {
+        return m_version.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<uint64_t> m_version;
+    T m_value;
+};
+}
+
+#endif
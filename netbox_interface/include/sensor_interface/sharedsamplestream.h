@@ -0,0 +1,90 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_SHAREDSAMPLESTREAM_H
+#define ESTIMATION_SENSOR_INTERFACE_SHAREDSAMPLESTREAM_H
+
+#include "sensor_interface/samplehistory.h"
+#include "sensor_interface/sensorsample.h"
+
+#include <span>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <optional>
+
+#include <Eigen/Core>
+
+namespace estimation::sensor_interface {
+class SensorController;
+
+// Layout at the start of the shared-memory segment; the sample slots follow at SLOTS_OFFSET.
+struct SharedStreamHeader
+{
+    static constexpr uint64_t MAGIC = 0x314d485358424e4eull; // "NNBXSHM1"
+    static constexpr uint32_t VERSION = 1u;
+    static constexpr std::size_t SLOTS_OFFSET = 256u;
+
+    std::atomic<uint64_t> magic;
+    uint32_t version;
+    uint32_t slot_size;
+    uint64_t capacity;
+    int64_t publisher_pid;
+    std::atomic<uint32_t> connected;
+    alignas(64) std::atomic<uint64_t> head;
+    // Futex word bumped after every published sample while waiters is non-zero, and on every connection change.
+    alignas(64) std::atomic<uint32_t> published;
+    std::atomic<uint32_t> waiters;
+};
+
+// Republishes one SensorController's samples into a POSIX shared-memory ring named name (as for shm_open()).
+// The ring is the same seqlocked SampleHistory the controller uses, so any number of local processes can read it
+// through SharedSampleSubscriber without the publisher knowing about them. Sequences are the ring's own, starting at 1.
+// Destroying the publisher removes the name; the mapping itself lives on until the controller drops its listeners.
+// A name still owned by a live publisher process is refused with std::runtime_error; a segment left behind by one
+// that died is taken over.
+class SharedSamplePublisher
+{
+public:
+    SharedSamplePublisher(const std::string &name, SensorController &controller,
+                          std::size_t capacity = 1u << 16, bool filtered = false);
+    ~SharedSamplePublisher();
+
+    SharedSamplePublisher(const SharedSamplePublisher &) = delete;
+    SharedSamplePublisher &operator=(const SharedSamplePublisher &) = delete;
+
+    const std::string &name() const;
+
+private:
+    struct Segment;
+
+    std::string m_name;
+    std::shared_ptr<Segment> m_segment;
+};
+
+// Read side of a SharedSamplePublisher, with SensorController's read API. Reads copy straight out of the shared
+// ring; nothing goes through the network or the publisher.
+class SharedSampleSubscriber
+{
+public:
+    explicit SharedSampleSubscriber(const std::string &name);
+    ~SharedSampleSubscriber();
+
+    SharedSampleSubscriber(const SharedSampleSubscriber &) = delete;
+    SharedSampleSubscriber &operator=(const SharedSampleSubscriber &) = delete;
+
+    bool hasConnectedSensor() const;
+
+    std::pair<Eigen::Vector3d, Eigen::Vector3d> currentRawLoad() const;
+    SensorSample latestSample() const;
+    std::optional<SensorSample> waitForNext(uint64_t last_sequence, std::chrono::nanoseconds timeout);
+
+    const SampleHistory &sampleHistory() const;
+    std::size_t readSamplesSince(uint64_t &sequence, std::span<SensorSample> samples) const;
+
+private:
+    std::size_t m_size;
+    SharedStreamHeader *m_header;
+    std::unique_ptr<SampleHistory> m_history;
+};
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_SPSCQUEUE_H
+#define ESTIMATION_SENSOR_INTERFACE_SPSCQUEUE_H
+
+#include <bit>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <algorithm>
+
+namespace estimation::sensor_interface {
+// Bounded wait-free queue for exactly one producer thread and one consumer thread.
+template<typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(std::size_t capacity)
+    : m_mask(std::bit_ceil(std::max<std::size_t>(capacity, 2u)) - 1u)
+    , m_items(std::make_unique<T[]>(m_mask + 1u))
+    , m_head(0u)
+    , m_tail(0u)
+    , m_cached_head(0u)
+    , m_cached_tail(0u)
+    {
+    }
+
+    std::size_t capacity() const
+    {
+        return m_mask + 1u;
+    }
+
+    std::size_t size() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    bool tryPush(const T &value)
+    {
+        auto tail = m_tail.load(std::memory_order_relaxed);
+        if(tail - m_cached_head > m_mask)
+        {
+            m_cached_head = m_head.load(std::memory_order_acquire);
+            if(tail - m_cached_head > m_mask)
+                return false;
+        }
+        m_items[tail & m_mask] = value;
+        m_tail.store(tail + 1u, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T &value)
+    {
+        auto head = m_head.load(std::memory_order_relaxed);
+        if(head == m_cached_tail)
+        {
+            m_cached_tail = m_tail.load(std::memory_order_acquire);
+            if(head == m_cached_tail)
+                return false;
+        }
+        value = m_items[head & m_mask];
+        m_head.store(head + 1u, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only: the oldest element, valid until the next pop.
+    T *front()
+    {
+        auto head = m_head.load(std::memory_order_relaxed);
+        if(head == m_cached_tail)
+        {
+            m_cached_tail = m_tail.load(std::memory_order_acquire);
+            if(head == m_cached_tail)
+                return nullptr;
+        }
+        return &m_items[head & m_mask];
+    }
+
+    void pop()
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1u, std::memory_order_release);
+    }
+
+private:
+    std::size_t m_mask;
+    std::unique_ptr<T[]> m_items;
+    alignas(64) std::atomic<std::size_t> m_head;
+    alignas(64) std::atomic<std::size_t> m_tail;
+    alignas(64) std::size_t m_cached_head;
+    alignas(64) std::size_t m_cached_tail;
+};
+}
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_STATICSENSORCONTROLLER_H
+#define ESTIMATION_SENSOR_INTERFACE_STATICSENSORCONTROLLER_H
+
+#include "sensor_interface/calibration.h"
+#include "sensor_interface/sensorsample.h"
+#include "sensor_interface/netboxrdtclient.h"
+
+#include <span>
+#include <array>
+#include <utility>
+#include <algorithm>
+
+namespace estimation::sensor_interface {
+// SensorController for a single consumer known at compile time. Calibrated samples go straight to
+// sink(const SensorSample &) with no std::function, lock or heap allocation between the socket and the sink, so
+// decode and delivery inline into the caller's loop. There is no receive thread, history or listener list: the owner
+// drives the controller from one thread through ingest() or poll(), and configures it from that same thread.
+template<typename Sink>
+class StaticSensorController
+{
+public:
+    template<typename... Args>
+    explicit StaticSensorController(Args &&...args)
+    : m_sink(std::forward<Args>(args)...)
+    , m_calibration(Calibration::fromCountsPerUnit(1000000.0, 1000000.0))
+    , m_unit(0u)
+    , m_sequence(0u)
+    {
+    }
+
+    void setCalibration(const Calibration &calibration)
+    {
+        m_calibration = calibration;
+    }
+
+    const Calibration &calibration() const
+    {
+        return m_calibration;
+    }
+
+    // Unit of a START_MULTI_UNIT_STREAMING client whose records poll() delivers.
+    void setUnit(uint32_t unit)
+    {
+        m_unit = unit;
+    }
+
+    void ingest(std::span<const RTDResponse> batch, SampleTime received = std::chrono::system_clock::now())
+    {
+        auto now = std::chrono::system_clock::now();
+        std::array<std::array<double, 6>, CHUNK> loads;
+        for(std::size_t offset = 0; offset < batch.size(); offset += CHUNK)
+        {
+            auto chunk = batch.subspan(offset, std::min(CHUNK, batch.size() - offset));
+            m_calibration.convert(chunk, loads.data());
+            for(std::size_t i = 0; i < chunk.size(); i++)
+            {
+                SensorSample sample;
+                sample.sequence = ++m_sequence;
+                sample.timestamp = received;
+                sample.latency = now - received;
+                sample.load = loads[i];
+                m_sink(sample);
+            }
+        }
+    }
+
+#ifdef NETBOX_LINUX_SOCKET
+    // Drains a client opened with NetboxStreamSettings::receive_thread = false straight into the sink; the client's
+    // own listeners are bypassed.
+    std::size_t poll(NetboxRdtClient &client)
+    {
+        return client.poll([this](uint32_t unit, std::span<const RTDResponse> batch, SampleTime received)
+        {
+            if(unit == m_unit)
+                ingest(batch, received);
+        });
+    }
+#endif
+
+    // Sequence of the last sample handed to the sink; samples are numbered from 1.
+    uint64_t sequence() const
+    {
+        return m_sequence;
+    }
+
+    Sink &sink()
+    {
+        return m_sink;
+    }
+
+    const Sink &sink() const
+    {
+        return m_sink;
+    }
+
+private:
+    static constexpr std::size_t CHUNK = 64u;
+
+    Sink m_sink;
+    Calibration m_calibration;
+    uint32_t m_unit;
+    uint64_t m_sequence;
+};
+}
+
+#endif
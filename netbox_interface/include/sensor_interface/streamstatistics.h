@@ -0,0 +1,83 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_STREAMSTATISTICS_H
+#define ESTIMATION_SENSOR_INTERFACE_STREAMSTATISTICS_H
+
+#include "sensor_interface/sensorsample.h"
+
+#include <span>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace estimation::sensor_interface {
+struct RTDResponse;
+
+struct StreamStatisticsSnapshot
+{
+    static constexpr std::size_t HISTOGRAM_BUCKETS = 16u;
+
+    uint64_t datagrams = 0;
+    uint64_t records = 0;
+    uint64_t dropped = 0;
+    uint64_t duplicated = 0;
+    uint64_t reordered = 0;
+    uint64_t sensor_skipped = 0;
+    uint64_t status_flagged = 0;
+    uint32_t last_status = 0;
+    double sample_rate = 0.0;
+    double jitter = 0.0;
+    // Datagram inter-arrival times; bucket 0 counts gaps below 1 us, bucket i gaps in [2^(i-1), 2^i) us and the
+    // last bucket everything longer.
+    std::array<uint64_t, HISTOGRAM_BUCKETS> interarrival_histogram{};
+    // Time from kernel receive to the receive thread picking the datagram up, bucketed like interarrival_histogram.
+    std::chrono::nanoseconds max_wakeup_latency{0};
+    std::array<uint64_t, HISTOGRAM_BUCKETS> wakeup_latency_histogram{};
+};
+
+// Health counters for one record stream. Updated by the receiving thread only; snapshot() may be called from any
+// thread and never blocks the writer.
+class StreamStatistics
+{
+public:
+    StreamStatistics();
+
+    void update(std::span<const RTDResponse> batch, SampleTime arrival);
+    void recordWakeup(std::chrono::nanoseconds latency);
+    void reset();
+    // Forgets the sequence and arrival position but keeps the counters, e.g. after the Netbox restarted its stream.
+    void resynchronize();
+
+    StreamStatisticsSnapshot snapshot() const;
+
+private:
+    typedef std::atomic<uint64_t> Counter;
+
+    Counter m_datagrams;
+    Counter m_records;
+    Counter m_dropped;
+    Counter m_duplicated;
+    Counter m_reordered;
+    Counter m_sensor_skipped;
+    Counter m_status_flagged;
+    std::atomic<uint32_t> m_last_status;
+    std::atomic<double> m_sample_rate;
+    std::atomic<double> m_jitter;
+    std::array<Counter, StreamStatisticsSnapshot::HISTOGRAM_BUCKETS> m_histogram;
+    std::atomic<int64_t> m_max_wakeup_latency;
+    std::array<Counter, StreamStatisticsSnapshot::HISTOGRAM_BUCKETS> m_wakeup_histogram;
+
+    // Receive-thread state.
+    bool m_started;
+    uint32_t m_highest_sequence;
+    uint64_t m_sequence_window;
+    uint32_t m_last_ft_sequence;
+    SampleTime m_last_arrival;
+    SampleTime m_rate_window_start;
+    uint64_t m_rate_window_records;
+    double m_mean_interval;
+
+    void trackSequence(const RTDResponse &response);
+    void trackArrival(SampleTime arrival, std::size_t records);
+};
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef ESTIMATION_SENSOR_INTERFACE_WINDOWSTATISTICS_H
+#define ESTIMATION_SENSOR_INTERFACE_WINDOWSTATISTICS_H
+
+#include "sensor_interface/seqlock.h"
+#include "sensor_interface/sensorsample.h"
+
+#include <span>
+#include <array>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+namespace estimation::sensor_interface {
+struct WindowStatisticsSnapshot
+{
+    // Configured window length and the number of samples currently in it (less until the window has filled).
+    std::size_t window = 0;
+    std::size_t count = 0;
+    uint64_t sequence = 0;
+    std::array<double, 6> mean{};
+    // Sample variance (n - 1 denominator).
+    std::array<double, 6> variance{};
+    std::array<double, 6> min{};
+    std::array<double, 6> max{};
+    std::array<double, 6> rms{};
+};
+
+// Sliding-window mean, variance, min, max and RMS of all six channels over up to MAX_WINDOWS window lengths.
+// update() is O(1) amortized per window: mean and variance follow Welford's recurrence with the sample leaving the
+// window removed, and are recomputed from the window once per window length so rounding cannot accumulate; min and
+// max come from monotonic deques. Each window is published through a SeqLock after every update, so snapshot()
+// never blocks the writer.
+class WindowStatistics
+{
+public:
+    static constexpr std::size_t MAX_WINDOWS = 8u;
+
+    WindowStatistics();
+
+    // Writer side; drops all accumulated samples. Windows beyond MAX_WINDOWS are ignored.
+    void configure(std::span<const std::size_t> windows);
+    void update(const SensorSample &sample);
+    void reset();
+
+    std::size_t windowCount() const;
+    WindowStatisticsSnapshot snapshot(std::size_t window) const;
+
+private:
+    // Sample indices whose values are monotonic in one channel; the front is the window's min (or max).
+    struct MonotonicDeque
+    {
+        std::vector<uint64_t> indices;
+        uint64_t head = 0u;
+        uint64_t tail = 0u;
+    };
+
+    struct Window
+    {
+        std::size_t length = 0u;
+        std::size_t count = 0u;
+        // Slides since mean and m2 were last recomputed from the window.
+        std::size_t slides = 0u;
+        Eigen::Array<double, 6, 1> mean = Eigen::Array<double, 6, 1>::Zero();
+        Eigen::Array<double, 6, 1> m2 = Eigen::Array<double, 6, 1>::Zero();
+        std::array<MonotonicDeque, 6> min;
+        std::array<MonotonicDeque, 6> max;
+    };
+
+    std::vector<Window> m_windows;
+    std::vector<std::array<double, 6>> m_samples;
+    std::size_t m_sample_mask;
+    uint64_t m_index;
+    std::atomic<std::size_t> m_window_count;
+    std::array<SeqLock<WindowStatisticsSnapshot>, MAX_WINDOWS> m_published;
+
+    template<typename Compare>
+    void push(MonotonicDeque &deque, std::size_t channel, double value, Compare compare);
+    double front(const MonotonicDeque &deque, std::size_t channel) const;
+    void recompute(Window &window) const;
+};
+}
+
+#endif
@@ -0,0 +1,240 @@
+#include "sensor_interface/asyncdispatcher.h"
+#include "sensor_interface/seqlock.h"
+#include "sensor_interface/spscqueue.h"
+
+#include <bit>
+#include <stdexcept>
+
+using namespace estimation::sensor_interface;
+
+namespace {
+constexpr std::size_t DRAIN_BATCH = 32u;
+}
+
+struct AsyncDispatcher::Subscriber
+{
+    struct Entry
+    {
+        uint64_t index;
+        SensorSample sample;
+    };
+
+    Listener listener;
+    BackpressurePolicy policy;
+    AsyncListenerOptions::Executor executor;
+    uint32_t stream;
+
+    // BLOCK uses a plain SPSC queue, DROP_OLDEST a ring of seqlocked slots that the publisher may lap, and
+    // COALESCE the same ring with a single slot.
+    std::unique_ptr<SpscQueue<SensorSample>> queue;
+    std::unique_ptr<SeqLock<Entry>[]> ring;
+    std::size_t mask = 0u;
+
+    alignas(64) std::atomic<uint64_t> published{0};
+    alignas(64) std::atomic<uint64_t> consumed{0};
+    std::atomic<uint64_t> delivered{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<int64_t> lag{0};
+    std::atomic<int64_t> max_lag{0};
+    std::atomic<bool> scheduled{false};
+
+    Subscriber(Listener l, const AsyncListenerOptions &options, uint32_t s)
+    : listener(std::move(l))
+    , policy(options.policy)
+    , executor(options.executor)
+    , stream(s)
+    {
+        auto capacity = std::max<std::size_t>(options.capacity, 1u);
+        if(policy == BackpressurePolicy::BLOCK)
+            queue = std::make_unique<SpscQueue<SensorSample>>(capacity);
+        else
+        {
+            mask = policy == BackpressurePolicy::COALESCE ? 0u : std::bit_ceil(capacity) - 1u;
+            ring = std::make_unique<SeqLock<Entry>[]>(mask + 1u);
+        }
+    }
+
+    bool pending() const
+    {
+        if(queue)
+            return queue->size() != 0u;
+        return published.load(std::memory_order_acquire) != consumed.load(std::memory_order_relaxed);
+    }
+
+    // Returns false if the sample could not be queued because the dispatcher stopped while blocking.
+    bool push(const SensorSample &sample, const std::atomic<bool> &running, const std::function<void()> &wake)
+    {
+        auto index = published.load(std::memory_order_relaxed);
+        if(queue)
+        {
+            while(!queue->tryPush(sample))
+            {
+                if(!running.load(std::memory_order_relaxed))
+                {
+                    dropped.fetch_add(1u, std::memory_order_relaxed);
+                    published.store(index + 1u, std::memory_order_release);
+                    return false;
+                }
+                wake();
+                std::this_thread::yield();
+            }
+        }
+        else
+            ring[index & mask].store(Entry{index, sample});
+        published.store(index + 1u, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t drain(std::size_t limit)
+    {
+        std::size_t count = 0u;
+        SensorSample sample;
+        while(count < limit)
+        {
+            if(queue)
+            {
+                if(!queue->tryPop(sample))
+                    break;
+            }
+            else
+            {
+                auto cursor = consumed.load(std::memory_order_relaxed);
+                if(cursor == published.load(std::memory_order_acquire))
+                    break;
+                // The slot may already hold a newer sample if the publisher lapped us; everything in between is lost.
+                auto entry = ring[cursor & mask].load();
+                if(entry.index > cursor)
+                    dropped.fetch_add(entry.index - cursor, std::memory_order_relaxed);
+                consumed.store(entry.index + 1u, std::memory_order_relaxed);
+                sample = entry.sample;
+            }
+            deliver(sample);
+            count++;
+        }
+        return count;
+    }
+
+    void deliver(const SensorSample &sample)
+    {
+        listener(sample);
+        auto age = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now() - sample.timestamp).count();
+        lag.store(age, std::memory_order_relaxed);
+        if(age > max_lag.load(std::memory_order_relaxed))
+            max_lag.store(age, std::memory_order_relaxed);
+        delivered.fetch_add(1u, std::memory_order_relaxed);
+    }
+};
+
+AsyncDispatcher::AsyncDispatcher()
+: m_subscriber_count(0u)
+, m_signal(0u)
+, m_running(true)
+{
+}
+
+AsyncDispatcher::~AsyncDispatcher()
+{
+    stop();
+}
+
+std::size_t AsyncDispatcher::subscribe(Listener listener, const AsyncListenerOptions &options, uint32_t stream)
+{
+    std::lock_guard<std::mutex> l(m_subscribe_lock);
+    auto index = m_subscriber_count.load(std::memory_order_relaxed);
+    if(index == MAX_SUBSCRIBERS)
+        throw std::length_error("Too many asynchronous subscribers");
+    m_subscribers[index] = std::make_shared<Subscriber>(std::move(listener), options, stream);
+    m_subscriber_count.store(index + 1u, std::memory_order_release);
+    if(!options.executor && !m_worker.joinable() && m_running)
+        m_worker = std::thread(&AsyncDispatcher::run, this);
+    return index;
+}
+
+std::size_t AsyncDispatcher::subscriberCount() const
+{
+    return m_subscriber_count.load(std::memory_order_acquire);
+}
+
+void AsyncDispatcher::publish(const SensorSample &sample, uint32_t stream)
+{
+    auto count = m_subscriber_count.load(std::memory_order_acquire);
+    bool queued = false;
+    for(std::size_t i = 0; i < count; i++)
+    {
+        const auto &subscriber = m_subscribers[i];
+        if(subscriber->stream != stream)
+            continue;
+        if(subscriber->executor)
+        {
+            subscriber->push(sample, m_running, [&subscriber]() { schedule(subscriber); });
+            schedule(subscriber);
+        }
+        else
+            queued |= subscriber->push(sample, m_running, [this]() { wake(); });
+    }
+    if(queued)
+        wake();
+}
+
+SubscriberStatistics AsyncDispatcher::statistics(std::size_t subscriber) const
+{
+    if(subscriber >= subscriberCount())
+        return {};
+    const auto &s = *m_subscribers[subscriber];
+    SubscriberStatistics statistics;
+    statistics.published = s.published.load(std::memory_order_acquire);
+    statistics.delivered = s.delivered.load(std::memory_order_relaxed);
+    statistics.dropped = s.dropped.load(std::memory_order_relaxed);
+    auto handled = statistics.delivered + statistics.dropped;
+    statistics.queued = statistics.published > handled ? statistics.published - handled : 0u;
+    statistics.lag = std::chrono::nanoseconds(s.lag.load(std::memory_order_relaxed));
+    statistics.max_lag = std::chrono::nanoseconds(s.max_lag.load(std::memory_order_relaxed));
+    return statistics;
+}
+
+void AsyncDispatcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> l(m_subscribe_lock);
+        m_running = false;
+    }
+    wake();
+    if(m_worker.joinable())
+        m_worker.join();
+}
+
+void AsyncDispatcher::run()
+{
+    while(m_running.load(std::memory_order_relaxed))
+    {
+        auto signal = m_signal.load(std::memory_order_acquire);
+        std::size_t delivered = 0u;
+        auto count = m_subscriber_count.load(std::memory_order_acquire);
+        for(std::size_t i = 0; i < count; i++)
+        {
+            if(!m_subscribers[i]->executor)
+                delivered += m_subscribers[i]->drain(DRAIN_BATCH);
+        }
+        if(delivered == 0u)
+            m_signal.wait(signal, std::memory_order_acquire);
+    }
+}
+
+void AsyncDispatcher::wake()
+{
+    m_signal.fetch_add(1u, std::memory_order_release);
+    m_signal.notify_one();
+}
+
+void AsyncDispatcher::schedule(const std::shared_ptr<Subscriber> &subscriber)
+{
+    if(subscriber->scheduled.exchange(true, std::memory_order_acq_rel))
+        return;
+    subscriber->executor([subscriber]()
+    {
+        subscriber->drain(DRAIN_BATCH);
+        subscriber->scheduled.store(false, std::memory_order_release);
+        if(subscriber->pending())
+            schedule(subscriber);
+    });
+}
@@ -0,0 +1,125 @@
+#include "sensor_interface/calibration.h"
+#include "sensor_interface/netboxrdtclient.h"
+
+#include <cstddef>
+
+using namespace estimation::sensor_interface;
+
+namespace {
+constexpr std::size_t CHUNK = 8u;
+constexpr std::size_t RECORD_WORDS = sizeof(RTDResponse) / sizeof(int32_t);
+
+static_assert(sizeof(RTDResponse) == RTD_RESPONSE_SIZE, "RTDResponse must mirror the 36-byte wire record");
+static_assert(sizeof(std::array<double, 6>) == 6u * sizeof(double), "Wrench arrays are mapped as Eigen columns");
+static_assert(offsetof(RTDResponse, tz) - offsetof(RTDResponse, fx) == 5u * sizeof(int32_t), "Fx..Tz must be contiguous");
+
+template<int Columns>
+using CountBlock = Eigen::Map<const Eigen::Matrix<int32_t, 6, Columns>, Eigen::Unaligned, Eigen::OuterStride<RECORD_WORDS>>;
+
+template<int Columns>
+using WrenchBlock = Eigen::Map<Eigen::Matrix<double, 6, Columns>>;
+
+template<Calibration::Kind Kind, int Columns>
+void convertBlock(const RTDResponse *records, const Matrix6d &matrix, std::array<double, 6> *wrenches)
+{
+    CountBlock<Columns> counts(&records->fx);
+    WrenchBlock<Columns> out(wrenches->data());
+    if constexpr(Kind == Calibration::Kind::IDENTITY)
+        out = counts.template cast<double>();
+    else if constexpr(Kind == Calibration::Kind::DIAGONAL)
+        out = matrix.diagonal().asDiagonal() * counts.template cast<double>();
+    else
+        out.noalias() = matrix * counts.template cast<double>();
+}
+
+template<Calibration::Kind Kind>
+void convertRecords(std::span<const RTDResponse> records, const Matrix6d &matrix, std::array<double, 6> *wrenches)
+{
+    std::size_t i = 0;
+    for(; i + CHUNK <= records.size(); i += CHUNK)
+        convertBlock<Kind, CHUNK>(&records[i], matrix, &wrenches[i]);
+    for(; i < records.size(); i++)
+        convertBlock<Kind, 1>(&records[i], matrix, &wrenches[i]);
+}
+
+Eigen::Matrix3d skew(const Eigen::Vector3d &v)
+{
+    Eigen::Matrix3d m;
+    m <<     0.0, -v.z(),  v.y(),
+           v.z(),    0.0, -v.x(),
+          -v.y(),  v.x(),    0.0;
+    return m;
+}
+}
+
+Calibration::Calibration()
+: m_kind(Kind::IDENTITY)
+, m_calibration(Matrix6d::Identity())
+, m_tool_transform(Matrix6d::Identity())
+, m_matrix(Matrix6d::Identity())
+{
+}
+
+Calibration Calibration::fromCountsPerUnit(double count_per_force, double count_per_torque)
+{
+    Vector6d gains;
+    gains << Eigen::Vector3d::Constant(1.0 / count_per_force), Eigen::Vector3d::Constant(1.0 / count_per_torque);
+    return fromMatrix(gains.asDiagonal());
+}
+
+Calibration Calibration::fromMatrix(const Matrix6d &counts_to_wrench)
+{
+    Calibration calibration;
+    calibration.m_calibration = counts_to_wrench;
+    calibration.update();
+    return calibration;
+}
+
+void Calibration::setToolTransform(const Eigen::Isometry3d &tool_from_sensor)
+{
+    const Eigen::Matrix3d rotation = tool_from_sensor.rotation();
+    m_tool_transform.setZero();
+    m_tool_transform.topLeftCorner<3, 3>() = rotation;
+    m_tool_transform.bottomRightCorner<3, 3>() = rotation;
+    m_tool_transform.bottomLeftCorner<3, 3>() = skew(tool_from_sensor.translation()) * rotation;
+    update();
+}
+
+Calibration::Kind Calibration::kind() const
+{
+    return m_kind;
+}
+
+const Matrix6d &Calibration::matrix() const
+{
+    return m_matrix;
+}
+
+void Calibration::convert(std::span<const RTDResponse> records, std::array<double, 6> *wrenches) const
+{
+    switch(m_kind)
+    {
+    case Kind::IDENTITY:
+        convertRecords<Kind::IDENTITY>(records, m_matrix, wrenches);
+        break;
+    case Kind::DIAGONAL:
+        convertRecords<Kind::DIAGONAL>(records, m_matrix, wrenches);
+        break;
+    case Kind::FULL:
+        convertRecords<Kind::FULL>(records, m_matrix, wrenches);
+        break;
+    }
+}
+
+void Calibration::update()
+{
+    m_matrix = m_tool_transform * m_calibration;
+    Matrix6d off_diagonal = m_matrix;
+    off_diagonal.diagonal().setZero();
+    if(!off_diagonal.isZero(0.0))
+        m_kind = Kind::FULL;
+    else if(m_matrix.diagonal().isOnes(0.0))
+        m_kind = Kind::IDENTITY;
+    else
+        m_kind = Kind::DIAGONAL;
+}
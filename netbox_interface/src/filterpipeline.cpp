@@ -0,0 +1,173 @@
+#include "sensor_interface/filterpipeline.h"
+
+#include <cmath>
+#include <numbers>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace estimation::sensor_interface;
+
+BiquadCoefficients BiquadCoefficients::lowPass(double cutoff, double sample_rate, double q)
+{
+    auto w0 = 2.0 * std::numbers::pi * cutoff / sample_rate;
+    auto alpha = std::sin(w0) / (2.0 * q);
+    auto cosw0 = std::cos(w0);
+    auto a0 = 1.0 + alpha;
+    BiquadCoefficients c;
+    c.b0 = (1.0 - cosw0) / 2.0 / a0;
+    c.b1 = (1.0 - cosw0) / a0;
+    c.b2 = c.b0;
+    c.a1 = -2.0 * cosw0 / a0;
+    c.a2 = (1.0 - alpha) / a0;
+    return c;
+}
+
+BiquadCoefficients BiquadCoefficients::notch(double frequency, double sample_rate, double q)
+{
+    auto w0 = 2.0 * std::numbers::pi * frequency / sample_rate;
+    auto alpha = std::sin(w0) / (2.0 * q);
+    auto cosw0 = std::cos(w0);
+    auto a0 = 1.0 + alpha;
+    BiquadCoefficients c;
+    c.b0 = 1.0 / a0;
+    c.b1 = -2.0 * cosw0 / a0;
+    c.b2 = c.b0;
+    c.a1 = c.b1;
+    c.a2 = (1.0 - alpha) / a0;
+    return c;
+}
+
+FilterPipeline::FilterPipeline(double sample_rate)
+: m_input_rate(sample_rate)
+, m_output_rate(sample_rate)
+{
+}
+
+FilterPipeline &FilterPipeline::lowPass(double cutoff, unsigned order)
+{
+    if(order < 2u || order % 2u != 0u)
+        throw std::invalid_argument("Low-pass order must be a positive even number");
+    if(cutoff <= 0.0 || cutoff >= m_output_rate / 2.0)
+        throw std::invalid_argument("Low-pass cutoff must lie between 0 and the Nyquist frequency");
+    for(unsigned k = 0; k < order / 2u; k++)
+    {
+        auto q = 1.0 / (2.0 * std::cos(std::numbers::pi * (2.0 * k + 1.0) / (2.0 * order)));
+        biquad(BiquadCoefficients::lowPass(cutoff, m_output_rate, q));
+    }
+    return *this;
+}
+
+FilterPipeline &FilterPipeline::notch(double frequency, double q)
+{
+    if(frequency <= 0.0 || frequency >= m_output_rate / 2.0)
+        throw std::invalid_argument("Notch frequency must lie between 0 and the Nyquist frequency");
+    return biquad(BiquadCoefficients::notch(frequency, m_output_rate, q));
+}
+
+FilterPipeline &FilterPipeline::biquad(const BiquadCoefficients &coefficients)
+{
+    Stage stage;
+    stage.kind = StageKind::BIQUAD;
+    stage.coefficients = coefficients;
+    m_stages.push_back(std::move(stage));
+    return *this;
+}
+
+FilterPipeline &FilterPipeline::movingAverage(std::size_t window)
+{
+    Stage stage;
+    stage.kind = StageKind::MOVING_AVERAGE;
+    stage.window.assign(std::max<std::size_t>(window, 1u), Channels::Zero());
+    m_stages.push_back(std::move(stage));
+    return *this;
+}
+
+FilterPipeline &FilterPipeline::decimate(unsigned factor)
+{
+    Stage stage;
+    stage.kind = StageKind::DECIMATE;
+    stage.factor = std::max(factor, 1u);
+    m_output_rate /= stage.factor;
+    m_stages.push_back(std::move(stage));
+    return *this;
+}
+
+bool FilterPipeline::empty() const
+{
+    return m_stages.empty();
+}
+
+double FilterPipeline::inputRate() const
+{
+    return m_input_rate;
+}
+
+double FilterPipeline::outputRate() const
+{
+    return m_output_rate;
+}
+
+bool FilterPipeline::process(Channels &channels)
+{
+    for(auto &stage : m_stages)
+    {
+        switch(stage.kind)
+        {
+        case StageKind::BIQUAD:
+        {
+            // Transposed direct form II.
+            const auto &c = stage.coefficients;
+            if(!stage.primed)
+            {
+                Channels steady = channels * ((c.b0 + c.b1 + c.b2) / (1.0 + c.a1 + c.a2));
+                stage.z2 = c.b2 * channels - c.a2 * steady;
+                stage.z1 = c.b1 * channels - c.a1 * steady + stage.z2;
+                stage.primed = true;
+            }
+            Channels y = c.b0 * channels + stage.z1;
+            stage.z1 = c.b1 * channels - c.a1 * y + stage.z2;
+            stage.z2 = c.b2 * channels - c.a2 * y;
+            channels = y;
+            break;
+        }
+        case StageKind::MOVING_AVERAGE:
+        {
+            auto &oldest = stage.window[stage.index];
+            stage.sum += channels - oldest;
+            oldest = channels;
+            stage.filled = std::min(stage.filled + 1u, stage.window.size());
+            if(++stage.index == stage.window.size())
+            {
+                // Re-sum once per window so rounding in the running sum cannot accumulate.
+                stage.index = 0u;
+                stage.sum.setZero();
+                for(const auto &value : stage.window)
+                    stage.sum += value;
+            }
+            channels = stage.sum / static_cast<double>(stage.filled);
+            break;
+        }
+        case StageKind::DECIMATE:
+            if(++stage.count < stage.factor)
+                return false;
+            stage.count = 0u;
+            break;
+        }
+    }
+    return true;
+}
+
+void FilterPipeline::reset()
+{
+    for(auto &stage : m_stages)
+    {
+        stage.z1.setZero();
+        stage.z2.setZero();
+        stage.sum.setZero();
+        std::fill(stage.window.begin(), stage.window.end(), Channels::Zero());
+        stage.index = 0u;
+        stage.filled = 0u;
+        stage.count = 0u;
+        stage.primed = false;
+    }
+}
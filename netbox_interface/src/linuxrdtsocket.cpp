@@ -0,0 +1,157 @@
+#include "sensor_interface/linuxrdtsocket.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+using namespace estimation::sensor_interface;
+
+namespace {
+std::runtime_error socketError(const std::string &what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+}
+
+LinuxRdtSocket::LinuxRdtSocket()
+: m_fd(-1)
+, m_iovecs(BATCH_SIZE)
+, m_headers(BATCH_SIZE)
+, m_arena(BATCH_SIZE)
+{
+    for(std::size_t i = 0; i < BATCH_SIZE; i++)
+    {
+        m_iovecs[i].iov_base = m_arena[i].data;
+        m_iovecs[i].iov_len = DATAGRAM_CAPACITY;
+        std::memset(&m_headers[i], 0, sizeof(mmsghdr));
+        m_headers[i].msg_hdr.msg_iov = &m_iovecs[i];
+        m_headers[i].msg_hdr.msg_iovlen = 1;
+        m_headers[i].msg_hdr.msg_control = m_arena[i].control;
+    }
+}
+
+LinuxRdtSocket::~LinuxRdtSocket()
+{
+    close();
+}
+
+void LinuxRdtSocket::open(const std::string &remote_ip, uint16_t port, int receive_buffer_size)
+{
+    close();
+    m_fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+    if(m_fd < 0)
+        throw socketError("Unable to create UDP socket");
+
+    // Several Netboxes stream to the same local port; each connected socket only receives from its own Netbox.
+    int reuse = 1;
+    ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse));
+    if(receive_buffer_size > 0)
+    {
+        // SO_RCVBUFFORCE ignores net.core.rmem_max but needs CAP_NET_ADMIN.
+        if(::setsockopt(m_fd, SOL_SOCKET, SO_RCVBUFFORCE, &receive_buffer_size, sizeof(receive_buffer_size)) != 0)
+            ::setsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, &receive_buffer_size, sizeof(receive_buffer_size));
+    }
+    int timestamps = 1;
+    ::setsockopt(m_fd, SOL_SOCKET, SO_TIMESTAMPNS, &timestamps, sizeof(timestamps));
+    timeval timeout{0, 100000};
+    ::setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(port);
+    if(::bind(m_fd, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0)
+    {
+        auto error = socketError("Unable to bind UDP port " + std::to_string(port));
+        close();
+        throw error;
+    }
+
+    sockaddr_in remote{};
+    remote.sin_family = AF_INET;
+    remote.sin_port = htons(port);
+    if(::inet_pton(AF_INET, remote_ip.c_str(), &remote.sin_addr) != 1 ||
+       ::connect(m_fd, reinterpret_cast<const sockaddr*>(&remote), sizeof(remote)) != 0)
+    {
+        close();
+        throw std::runtime_error("Unable to connect to ATI Netbox on " + remote_ip + ":" + std::to_string(port));
+    }
+}
+
+void LinuxRdtSocket::close()
+{
+    if(m_fd < 0)
+        return;
+    ::close(m_fd);
+    m_fd = -1;
+}
+
+bool LinuxRdtSocket::isOpen() const
+{
+    return m_fd >= 0;
+}
+
+int LinuxRdtSocket::nativeHandle() const
+{
+    return m_fd;
+}
+
+int LinuxRdtSocket::receiveBufferSize() const
+{
+    int size = 0;
+    socklen_t length = sizeof(size);
+    if(::getsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, &size, &length) != 0)
+        return -1;
+    return size;
+}
+
+void LinuxRdtSocket::setReceiveTimeout(std::chrono::microseconds timeout)
+{
+    timeval value{static_cast<time_t>(timeout.count() / 1000000), static_cast<suseconds_t>(timeout.count() % 1000000)};
+    ::setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &value, sizeof(value));
+}
+
+void LinuxRdtSocket::write(const void *data, std::size_t size)
+{
+    if(::send(m_fd, data, size, 0) < 0)
+        throw socketError("Unable to send RDT request");
+}
+
+std::size_t LinuxRdtSocket::receive(bool blocking)
+{
+    for(auto &header : m_headers)
+        header.msg_hdr.msg_controllen = sizeof(Datagram::control);
+    auto count = ::recvmmsg(m_fd, m_headers.data(), BATCH_SIZE, blocking ? MSG_WAITFORONE : MSG_DONTWAIT, nullptr);
+    if(count < 0)
+    {
+        if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ECONNREFUSED)
+            return 0;
+        throw socketError("Unable to receive RDT datagrams");
+    }
+    return static_cast<std::size_t>(count);
+}
+
+std::span<const unsigned char> LinuxRdtSocket::datagram(std::size_t index) const
+{
+    return {m_arena[index].data, m_headers[index].msg_len};
+}
+
+std::chrono::system_clock::time_point LinuxRdtSocket::timestamp(std::size_t index, std::chrono::system_clock::time_point fallback) const
+{
+    auto &header = const_cast<msghdr&>(m_headers[index].msg_hdr);
+    for(auto control = CMSG_FIRSTHDR(&header); control != nullptr; control = CMSG_NXTHDR(&header, control))
+    {
+        if(control->cmsg_level != SOL_SOCKET || control->cmsg_type != SCM_TIMESTAMPNS)
+            continue;
+        timespec time;
+        std::memcpy(&time, CMSG_DATA(control), sizeof(time));
+        auto since_epoch = std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+        return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(since_epoch));
+    }
+    return fallback;
+}
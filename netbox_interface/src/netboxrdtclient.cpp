@@ -2,16 +2,61 @@
 
 #include <functional>
 
-#include <winsock.h>
-
+#include <cstring>
+#include <algorithm>
 #include <stdexcept>
+#include <system_error>
+
+#ifdef NETBOX_LINUX_SOCKET
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#endif
 
 using namespace estimation::sensor_interface;
 
+#ifdef NETBOX_LINUX_SOCKET
+namespace {
+constexpr std::size_t PREFAULT_STACK_SIZE = 256u * 1024u;
+
+// Touches the receive thread's stack once so that, with the process memory locked, it stays resident.
+__attribute__((noinline)) void prefaultStack()
+{
+    volatile unsigned char stack[PREFAULT_STACK_SIZE];
+    std::memset(const_cast<unsigned char*>(stack), 0, sizeof(stack));
+}
+
+void applyRealtimeSettings(pthread_t thread, const RealtimeSettings &realtime)
+{
+    if(realtime.lock_memory && ::mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        throw std::system_error(errno, std::generic_category(), "mlockall");
+    if(realtime.cpu >= 0)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(realtime.cpu, &cpus);
+        if(auto error = pthread_setaffinity_np(thread, sizeof(cpus), &cpus))
+            throw std::system_error(error, std::generic_category(), "Unable to pin receive thread to CPU " + std::to_string(realtime.cpu));
+    }
+    if(realtime.priority > 0)
+    {
+        sched_param parameters{};
+        parameters.sched_priority = realtime.priority;
+        if(auto error = pthread_setschedparam(thread, SCHED_FIFO, &parameters))
+            throw std::system_error(error, std::generic_category(), "Unable to set SCHED_FIFO priority " + std::to_string(realtime.priority));
+    }
+}
+}
+#endif
+
 NetboxRdtClient::NetboxRdtClient()
 : m_connected(false)
 , m_streaming(false)
+, m_backoff(0)
+, m_unit_count(1u)
 {
+    m_batch.reserve(RTD_MAX_DATAGRAM_SIZE / RTD_RESPONSE_SIZE);
+    ensureStatistics(1u);
 }
 
 NetboxRdtClient::~NetboxRdtClient()
@@ -19,29 +64,97 @@ NetboxRdtClient::~NetboxRdtClient()
     stopStreaming();
 }
 
-void NetboxRit adddtClient::startStreaming(const std::string &netbox_ip, uint16_t netbox_port)
+void NetboxRdtClient::startStreaming(const std::string &netbox_ip, uint16_t netbox_port, const NetboxStreamSettings &settings)
 {
+#ifndef NETBOX_LINUX_SOCKET
+    if(settings.realtime.enabled())
+        throw std::runtime_error("Real-time receive settings require the Linux socket backend");
+    if(!settings.receive_thread)
+        throw std::runtime_error("Polling without a receive thread requires the Linux socket backend");
+    if(settings.stall_timeout.count() > 0)
+        throw std::runtime_error("The stall watchdog requires the Linux socket backend");
+#endif
+    openStream(netbox_ip, netbox_port, settings);
+    if(!settings.receive_thread)
+        return;
+    m_worker = std::thread([this, realtime = settings.realtime]()
+    {
+#ifdef NETBOX_LINUX_SOCKET
+        if(realtime.lock_memory)
+            prefaultStack();
+        while(m_streaming)
+        {
+            auto count = m_socket.receive(!realtime.busy_poll);
+            watchdog();
+            if(count == 0u)
+                continue;
+            datagramsReceived();
+            auto now = std::chrono::system_clock::now();
+            auto wakeup = now - m_socket.timestamp(0u, now);
+            for(uint32_t unit = 0; unit < m_unit_count; unit++)
+                m_statistics[unit]->recordWakeup(wakeup);
+            for(std::size_t i = 0; i < count; i++)
+            {
+                auto datagram = m_socket.datagram(i);
+                receiveMessage(datagram.data(), datagram.size(), m_socket.timestamp(i, now));
+            }
+        }
+#else
+        unsigned char buffer[RTD_MAX_DATAGRAM_SIZE];
+        while(m_streaming)
+        {
+            auto read = m_client_connection->read(buffer, RTD_MAX_DATAGRAM_SIZE);
+            watchdog();
+            if(read <= 0)
+                continue;
+            datagramsReceived();
+            receiveMessage(buffer, read, std::chrono::system_clock::now());
+        }
+#endif
+    });
+#ifdef NETBOX_LINUX_SOCKET
+    try
+    {
+        applyRealtimeSettings(m_worker.native_handle(), settings.realtime);
+    }
+    catch(...)
+    {
+        stopStreaming();
+        throw;
+    }
+#endif
+}
+
+void NetboxRdtClient::openStream(const std::string &netbox_ip, uint16_t netbox_port, const NetboxStreamSettings &settings)
+{
+    m_unit_count = settings.command == RTDCommand::START_MULTI_UNIT_STREAMING ? std::max(settings.unit_count, 1u) : 1u;
+    m_unit_batches.resize(m_unit_count);
+    ensureStatistics(m_unit_count);
+    for(uint32_t unit = 0; unit < m_unit_count; unit++)
+        m_statistics[unit]->reset();
+    for(auto &unit_batch : m_unit_batches)
+        unit_batch.reserve(m_batch.capacity() / m_unit_count + 1u);
+#ifdef NETBOX_LINUX_SOCKET
+    m_socket.open(netbox_ip, netbox_port, settings.receive_buffer_size);
+    if(settings.stall_timeout.count() > 0)
+        m_socket.setReceiveTimeout(std::min<std::chrono::microseconds>(std::chrono::milliseconds(100), settings.stall_timeout / 4));
+#else
     m_client = std::make_unique<simple_socket::UDPSocket>(netbox_port);
     m_client_connection = m_client->makeConnection(netbox_ip, netbox_port);
     if(m_client_connection == nullptr)
         throw std::runtime_error("Unable to connect to ATI Netbox on " + netbox_ip + ":" + std::to_string(netbox_port));
+#endif
     RTDRequest request
     {
-        RTDCommand::START_HIGH_SPEED_REALTIME_STREAM
+        settings.command,
+        settings.sample_count
     };
-    auto data = serialize(request);
-    m_client_connection->write(data.data(), data.size());
+    m_settings = settings;
+    m_last_datagram = std::chrono::steady_clock::now();
+    m_next_restart = m_last_datagram + settings.stall_timeout;
+    m_backoff = settings.reconnect_backoff_min;
+    sendRequest(request);
     m_streaming = true;
-    m_worker = std::thread([&]()
-    {
-        unsigned char buffer[2048];
-        while(m_streaming)
-        {
-            auto read = m_client_connection->read(buffer, 2048);
-            std::string payload(buffer, buffer + read);
-            receiveMessage(payload);
-        }
-    });
 }
 
 bool NetboxRdtClient::isStreaming() const
@@ -49,6 +162,21 @@ bool NetboxRdtClient::isStreaming() const
     return m_streaming;
 }
 
+#ifdef NETBOX_LINUX_SOCKET
+int NetboxRdtClient::nativeHandle() const
+{
+    return m_socket.nativeHandle();
+}
+
+std::size_t NetboxRdtClient::poll()
+{
+    return poll([this](uint32_t unit, std::span<const RTDResponse> batch, SampleTime arrival)
+    {
+        dispatch(unit, batch, arrival);
+    });
+}
+#endif
+
 void NetboxRdtClient::stopStreaming()
 {
     if(!m_streaming)
@@ -57,59 +185,165 @@ void NetboxRdtClient::stopStreaming()
     {
         RTDCommand::STOP_STREAM
     };
-    auto data = serialize(request);
-    m_client_connection->write(data.data(), data.size());
+    sendRequest(request);
     m_streaming = false;
-    m_worker.join();
+    if(m_worker.joinable())
+        m_worker.join();
+    connectedChanged(false);
+#ifdef NETBOX_LINUX_SOCKET
+    m_socket.close();
+#endif
 }
 
 void NetboxRdtClient::setSensorLoadListener(FTSensorLoadListener listener)
 {
+    requireClosed("setSensorLoadListener()");
     m_load_listener = listener;
 }
 
+void NetboxRdtClient::setSensorBatchListener(FTSensorBatchListener listener, uint32_t unit)
+{
+    requireClosed("setSensorBatchListener()");
+    if(unit >= m_batch_listeners.size())
+        m_batch_listeners.resize(unit + 1u);
+    m_batch_listeners[unit] = listener;
+    ensureStatistics(unit + 1u);
+}
+
+const StreamStatistics &NetboxRdtClient::statistics(uint32_t unit)
+{
+    ensureStatistics(unit + 1u);
+    return *m_statistics[unit];
+}
+
+StreamStatisticsSnapshot NetboxRdtClient::streamStatistics(uint32_t unit) const
+{
+    if(unit >= m_statistics.size())
+        return {};
+    return m_statistics[unit]->snapshot();
+}
+
+void NetboxRdtClient::ensureStatistics(std::size_t units)
+{
+    if(m_statistics.size() < units)
+        requireClosed("Adding stream statistics");
+    while(m_statistics.size() < units)
+        m_statistics.push_back(std::make_unique<StreamStatistics>());
+}
+
+void NetboxRdtClient::requireClosed(const char *operation) const
+{
+    if(m_streaming)
+        throw std::logic_error(std::string(operation) + " must be called before the Netbox stream is opened");
+}
+
+void NetboxRdtClient::addConnectionListener(NetboxConnectionListener listener)
+{
+    requireClosed("addConnectionListener()");
+    m_connection_listeners.push_back(listener);
+}
+
+bool NetboxRdtClient::isConnected() const
+{
+    return m_connected;
+}
+
+void NetboxRdtClient::watchdog()
+{
+    if(!m_streaming || m_settings.sample_count != 0u || m_settings.stall_timeout.count() <= 0)
+        return;
+    auto now = std::chrono::steady_clock::now();
+    if(now - m_last_datagram < m_settings.stall_timeout)
+        return;
+    if(m_connected)
+    {
+        connectedChanged(false);
+        m_backoff = m_settings.reconnect_backoff_min;
+        m_next_restart = now;
+    }
+    if(now < m_next_restart)
+        return;
+
+    // Restart on the same socket: a rebooted Netbox only needs the start request again, and begins its sequence
+    // counters from scratch.
+    for(uint32_t unit = 0; unit < m_unit_count; unit++)
+        m_statistics[unit]->resynchronize();
+    try
+    {
+        sendRequest(RTDRequest(RTDCommand::STOP_STREAM));
+        sendRequest(RTDRequest(m_settings.command, m_settings.sample_count));
+    }
+    catch(const std::exception &)
+    {
+        // Unreachable Netbox (e.g. ICMP port unreachable from a previous attempt); try again after the backoff.
+    }
+    m_next_restart = now + m_backoff;
+    m_backoff = std::min(m_backoff * 2, m_settings.reconnect_backoff_max);
+}
+
+void NetboxRdtClient::datagramsReceived()
+{
+    m_last_datagram = std::chrono::steady_clock::now();
+    if(!m_connected.load(std::memory_order_relaxed))
+        connectedChanged(true);
+}
+
 void NetboxRdtClient::connectedChanged(bool connected)
 {
-    m_connected = connected;
+    if(m_connected.exchange(connected) == connected)
+        return;
+    for(const auto &listener : m_connection_listeners)
+        listener(connected);
+}
+
+void NetboxRdtClient::setSoftwareBias()
+{
+    sendRequest(RTDRequest(RTDCommand::SET_SOFTWARE_BIAS));
 }
 
-std::string NetboxRdtClient::serialize(const RTDRequest &request)
+void NetboxRdtClient::resetThresholdLatch()
 {
-    std::string buffer;
-    buffer.resize(8);
-    auto raw_buf = buffer.data();
-    *(reinterpret_cast<uint16_t*>(&raw_buf[0])) = htons(0x1234);
-    *(reinterpret_cast<uint16_t*>(&raw_buf[2])) = htons(request.command);
-    *(reinterpret_cast<uint32_t*>(&raw_buf[4])) = htonl(request.sample_count);
-    return buffer;
+    sendRequest(RTDRequest(RTDCommand::RESET_THRESHOLD_LATCH));
 }
 
-void NetboxRdtClient::receiveMessage(const std::string &payload)
+void NetboxRdtClient::sendRequest(const RTDRequest &request)
 {
-    auto response = deserialize(payload);
-    m_load_listener
-    (
-        response.fx,
-        response.fy,
-        response.fz,
-        response.tx,
-        response.ty,
-        response.tz
-    );
+    auto data = RdtCodec::encode(request);
+#ifdef NETBOX_LINUX_SOCKET
+    m_socket.write(data.data(), data.size());
+#else
+    m_client_connection->write(data.data(), data.size());
+#endif
 }
 
-RTDResponse NetboxRdtClient::deserialize(const std::string &response)
+void NetboxRdtClient::receiveMessage(const unsigned char *payload, std::size_t size, SampleTime arrival)
 {
-    RTDResponse ret;
-    auto raw_buf = response.data();
-    ret.rdt_package_sequence_index = ntohl(*(reinterpret_cast<const uint32_t*>(&raw_buf[0])));
-    ret.ft_internal_sequence_index = ntohl(*(reinterpret_cast<const uint32_t*>(&raw_buf[4])));
-    ret.status = ntohl(*(reinterpret_cast<const uint32_t*>(&raw_buf[8])));
-    ret.fx = ntohl(*(reinterpret_cast<const int32_t*>(&raw_buf[12])));
-    ret.fy = ntohl(*(reinterpret_cast<const int32_t*>(&raw_buf[16])));
-    ret.fz = ntohl(*(reinterpret_cast<const int32_t*>(&raw_buf[20])));
-    ret.tx = ntohl(*(reinterpret_cast<const int32_t*>(&raw_buf[24])));
-    ret.ty = ntohl(*(reinterpret_cast<const int32_t*>(&raw_buf[28])));
-    ret.tz = ntohl(*(reinterpret_cast<const int32_t*>(&raw_buf[32])));
-    return ret;
+    auto listeners = [this](uint32_t unit, std::span<const RTDResponse> batch, SampleTime arrival)
+    {
+        dispatch(unit, batch, arrival);
+    };
+    receiveMessage(payload, size, arrival, listeners);
+}
+
+void NetboxRdtClient::dispatch(uint32_t unit, std::span<const RTDResponse> batch, SampleTime arrival)
+{
+    if(unit < m_batch_listeners.size() && m_batch_listeners[unit])
+    {
+        m_batch_listeners[unit](batch, arrival);
+        return;
+    }
+    if(!m_load_listener)
+        return;
+    for(const auto &response : batch)
+    {
+        m_load_listener
+        (
+            response.fx,
+            response.fy,
+            response.fz,
+            response.tx,
+            response.ty,
+            response.tz
+        );
+    }
 }
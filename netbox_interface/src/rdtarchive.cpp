@@ -0,0 +1,543 @@
+#include "sensor_interface/rdtarchive.h"
+#include "sensor_interface/sensorcontroller.h"
+
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace estimation::sensor_interface;
+
+namespace {
+static_assert(std::endian::native == std::endian::little, "Archive headers are written in host byte order");
+
+constexpr uint64_t ARCHIVE_MAGIC = 0x313043524158424eull; // "NBXARC01" in file byte order
+constexpr uint32_t CHUNK_MAGIC = 0x4b4e4843u;            // "CHNK"
+
+enum Column : std::size_t
+{
+    TIMESTAMP,
+    RDT_SEQUENCE,
+    FT_SEQUENCE,
+    STATUS,
+    FX,
+    FY,
+    FZ,
+    TX,
+    TY,
+    TZ,
+    UNIT,
+    COLUMN_COUNT
+};
+
+struct FileHeader
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t chunk_records;
+    double count_per_force;
+    double count_per_torque;
+};
+
+struct ChunkHeader
+{
+    uint32_t magic;
+    uint32_t record_count;
+    int64_t first_ns;
+    uint32_t column_size[COLUMN_COUNT];
+};
+
+struct FileTrailer
+{
+    uint64_t index_offset;
+    uint64_t chunk_count;
+    uint64_t magic;
+};
+
+uint64_t zigzag(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1u);
+}
+
+void putVarint(std::vector<uint8_t> &out, uint64_t value)
+{
+    while(value >= 0x80u)
+    {
+        out.push_back(static_cast<uint8_t>(value) | 0x80u);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+uint64_t getVarint(const uint8_t *&in, const uint8_t *end)
+{
+    uint64_t value = 0u;
+    for(unsigned shift = 0; in < end && shift < 64u; shift += 7u)
+    {
+        auto byte = *in++;
+        value |= static_cast<uint64_t>(byte & 0x7fu) << shift;
+        if(!(byte & 0x80u))
+            return value;
+    }
+    throw std::runtime_error("Corrupt archive column");
+}
+
+template<typename Field>
+void encodeDelta(std::vector<uint8_t> &out, std::span<const RecordedResponse> records, Field field)
+{
+    int64_t previous = 0;
+    for(const auto &record : records)
+    {
+        int64_t value = field(record);
+        putVarint(out, zigzag(value - previous));
+        previous = value;
+    }
+}
+
+template<typename Field>
+void encodeRuns(std::vector<uint8_t> &out, std::span<const RecordedResponse> records, Field field)
+{
+    std::size_t i = 0;
+    while(i < records.size())
+    {
+        auto value = field(records[i]);
+        std::size_t run = 1u;
+        while(i + run < records.size() && field(records[i + run]) == value)
+            run++;
+        putVarint(out, value);
+        putVarint(out, run);
+        i += run;
+    }
+}
+
+template<typename Store>
+void decodeDelta(const uint8_t *in, const uint8_t *end, std::span<RecordedResponse> records, int64_t start, Store store)
+{
+    int64_t value = start;
+    for(auto &record : records)
+    {
+        value += unzigzag(getVarint(in, end));
+        store(record, value);
+    }
+}
+
+template<typename Store>
+void decodeRuns(const uint8_t *in, const uint8_t *end, std::span<RecordedResponse> records, Store store)
+{
+    std::size_t i = 0;
+    while(i < records.size())
+    {
+        auto value = getVarint(in, end);
+        auto run = std::min<uint64_t>(getVarint(in, end), records.size() - i);
+        for(std::size_t r = 0; r < run; r++)
+            store(records[i + r], value);
+        i += run;
+    }
+}
+
+// Fx..Tz columns in Column order, shared by the encoder and the decoder.
+constexpr int32_t RTDResponse::*COUNT_FIELDS[] =
+{
+    &RTDResponse::fx, &RTDResponse::fy, &RTDResponse::fz,
+    &RTDResponse::tx, &RTDResponse::ty, &RTDResponse::tz
+};
+static_assert(std::size(COUNT_FIELDS) == TZ - FX + 1, "One count field per Fx..Tz column");
+}
+
+RdtArchiveWriter::RdtArchiveWriter(const std::string &path, double count_per_force, double count_per_torque, uint32_t chunk_records)
+: m_file(nullptr)
+, m_path(path)
+, m_offset(0u)
+, m_error(0)
+, m_chunk_records(std::max(chunk_records, 1u))
+, m_columns(COLUMN_COUNT)
+, m_appended(false)
+, m_running(false)
+{
+    m_file = std::fopen(path.c_str(), "wb");
+    if(!m_file)
+        throw std::runtime_error("Unable to create archive " + path + ": " + std::strerror(errno));
+    FileHeader header{ARCHIVE_MAGIC, 1u, m_chunk_records, count_per_force, count_per_torque};
+    write(&header, sizeof(header));
+    if(m_error != 0)
+    {
+        std::fclose(m_file);
+        m_file = nullptr;
+        checkError();
+    }
+    m_pending.reserve(m_chunk_records);
+}
+
+RdtArchiveWriter::~RdtArchiveWriter()
+{
+    try
+    {
+        close();
+    }
+    catch(const std::exception &)
+    {
+        // Write errors are reported by an explicit close() or error().
+    }
+}
+
+void RdtArchiveWriter::append(std::span<const RTDResponse> batch, SampleTime received, uint32_t unit)
+{
+    RecordedResponse record;
+    record.received_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(received.time_since_epoch()).count();
+    record.unit = unit;
+    for(const auto &response : batch)
+    {
+        record.response = response;
+        append(record);
+    }
+}
+
+void RdtArchiveWriter::append(const RecordedResponse &record)
+{
+    // The drain thread owns the pending chunk once a controller is attached.
+    if(m_queue)
+        throw std::logic_error("append() cannot be used on an archive writer fed by attach()");
+    m_appended = true;
+    checkError();
+    add(record);
+}
+
+void RdtArchiveWriter::attach(SensorController &controller, uint32_t unit)
+{
+    if(m_appended)
+        throw std::logic_error("attach() cannot be used on an archive writer fed by append()");
+    if(!m_queue)
+    {
+        m_queue = std::make_shared<RecordQueue>(std::max<std::size_t>(m_chunk_records, 1u << 16));
+        m_running = true;
+        m_worker = std::thread(&RdtArchiveWriter::drain, this);
+    }
+    controller.addRawBatchListener([queue = m_queue, unit](std::span<const RTDResponse> batch, SampleTime received)
+    {
+        queue->push(batch, received, unit);
+    });
+}
+
+uint64_t RdtArchiveWriter::dropped() const
+{
+    return m_queue ? m_queue->dropped() : 0u;
+}
+
+int RdtArchiveWriter::error() const
+{
+    return m_error.load();
+}
+
+void RdtArchiveWriter::close()
+{
+    if(!m_file)
+        return;
+    if(m_queue)
+        m_queue->close();
+    if(m_running.exchange(false))
+        m_worker.join();
+    try
+    {
+        flushChunk();
+    }
+    catch(const std::exception &)
+    {
+        // Latched in m_error; the file is still closed below.
+    }
+    FileTrailer trailer{m_offset, m_index.size(), ARCHIVE_MAGIC};
+    write(m_index.data(), m_index.size() * sizeof(ArchiveChunkInfo));
+    write(&trailer, sizeof(trailer));
+    if(std::fclose(m_file) != 0 && m_error == 0)
+        m_error = errno;
+    m_file = nullptr;
+    checkError();
+}
+
+// Once a write has failed the archive can no longer be completed, so every later write is skipped.
+void RdtArchiveWriter::write(const void *data, std::size_t size)
+{
+    if(size == 0u || m_error != 0)
+        return;
+    if(std::fwrite(data, 1u, size, m_file) != size)
+    {
+        m_error = errno != 0 ? errno : EIO;
+        return;
+    }
+    m_offset += size;
+}
+
+void RdtArchiveWriter::checkError() const
+{
+    if(auto error = m_error.load())
+        throw std::runtime_error("Unable to write archive " + m_path + ": " + std::strerror(error));
+}
+
+void RdtArchiveWriter::add(const RecordedResponse &record)
+{
+    m_pending.push_back(record);
+    if(m_pending.size() >= m_chunk_records)
+        flushChunk();
+}
+
+void RdtArchiveWriter::flushChunk()
+{
+    if(m_pending.empty())
+        return;
+    std::span<const RecordedResponse> records(m_pending);
+    for(std::size_t column = 0; column < COLUMN_COUNT; column++)
+    {
+        auto &out = m_columns[column];
+        out.clear();
+        switch(column)
+        {
+        case TIMESTAMP:
+            encodeDelta(out, records, [&](const RecordedResponse &r) { return r.received_ns - records.front().received_ns; });
+            break;
+        case RDT_SEQUENCE:
+            encodeDelta(out, records, [](const RecordedResponse &r) { return int64_t(r.response.rdt_package_sequence_index); });
+            break;
+        case FT_SEQUENCE:
+            encodeDelta(out, records, [](const RecordedResponse &r) { return int64_t(r.response.ft_internal_sequence_index); });
+            break;
+        case STATUS:
+            encodeRuns(out, records, [](const RecordedResponse &r) { return uint64_t(r.response.status); });
+            break;
+        case FX:
+        case FY:
+        case FZ:
+        case TX:
+        case TY:
+        case TZ:
+            encodeDelta(out, records, [field = COUNT_FIELDS[column - FX]](const RecordedResponse &r) { return int64_t(r.response.*field); });
+            break;
+        case UNIT:
+            encodeRuns(out, records, [](const RecordedResponse &r) { return uint64_t(r.unit); });
+            break;
+        }
+    }
+
+    ChunkHeader header{};
+    header.magic = CHUNK_MAGIC;
+    header.record_count = static_cast<uint32_t>(records.size());
+    header.first_ns = records.front().received_ns;
+    for(std::size_t column = 0; column < COLUMN_COUNT; column++)
+        header.column_size[column] = static_cast<uint32_t>(m_columns[column].size());
+
+    ArchiveChunkInfo info;
+    info.offset = m_offset;
+    info.first_ns = records.front().received_ns;
+    info.last_ns = records.back().received_ns;
+    info.record_count = records.size();
+    for(const auto &record : records)
+    {
+        info.first_ns = std::min(info.first_ns, record.received_ns);
+        info.last_ns = std::max(info.last_ns, record.received_ns);
+    }
+    m_index.push_back(info);
+
+    write(&header, sizeof(header));
+    for(const auto &column : m_columns)
+        write(column.data(), column.size());
+    m_pending.clear();
+    checkError();
+}
+
+void RdtArchiveWriter::drain()
+{
+    while(true)
+    {
+        auto running = m_running.load();
+        std::size_t drained = 0u;
+        RecordedResponse record;
+        while(m_queue->tryPop(record))
+        {
+            // After a write error the queue is still drained, so it is not reported as overflowing.
+            if(m_error == 0)
+            {
+                try
+                {
+                    add(record);
+                }
+                catch(const std::exception &)
+                {
+                    // Latched in m_error for error() and close().
+                }
+            }
+            drained++;
+        }
+        if(!running)
+            return;
+        if(drained == 0u)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+RdtArchiveReader::RdtArchiveReader(const std::string &path)
+: m_fd(-1)
+, m_data(nullptr)
+, m_size(0u)
+, m_count_per_force(1.0)
+, m_count_per_torque(1.0)
+{
+    m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(m_fd < 0)
+        throw std::runtime_error("Unable to open archive " + path + ": " + std::strerror(errno));
+    struct stat status;
+    if(::fstat(m_fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(FileHeader) + sizeof(FileTrailer)))
+    {
+        ::close(m_fd);
+        throw std::runtime_error("Archive " + path + " is truncated");
+    }
+    m_size = status.st_size;
+    auto mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+    if(mapping == MAP_FAILED)
+    {
+        ::close(m_fd);
+        throw std::runtime_error("Unable to map archive " + path + ": " + std::strerror(errno));
+    }
+    m_data = static_cast<const uint8_t*>(mapping);
+
+    FileHeader header;
+    FileTrailer trailer;
+    std::memcpy(&header, m_data, sizeof(header));
+    std::memcpy(&trailer, m_data + m_size - sizeof(trailer), sizeof(trailer));
+    auto index_size = trailer.chunk_count * sizeof(ArchiveChunkInfo);
+    if(header.magic != ARCHIVE_MAGIC || trailer.magic != ARCHIVE_MAGIC || trailer.index_offset + index_size + sizeof(trailer) != m_size)
+    {
+        ::munmap(mapping, m_size);
+        ::close(m_fd);
+        throw std::runtime_error(path + " is not a complete Netbox RDT archive");
+    }
+    m_count_per_force = header.count_per_force;
+    m_count_per_torque = header.count_per_torque;
+    m_chunks.resize(trailer.chunk_count);
+    std::memcpy(m_chunks.data(), m_data + trailer.index_offset, index_size);
+}
+
+RdtArchiveReader::~RdtArchiveReader()
+{
+    ::munmap(const_cast<uint8_t*>(m_data), m_size);
+    ::close(m_fd);
+}
+
+const std::vector<ArchiveChunkInfo> &RdtArchiveReader::chunks() const
+{
+    return m_chunks;
+}
+
+uint64_t RdtArchiveReader::recordCount() const
+{
+    uint64_t count = 0u;
+    for(const auto &chunk : m_chunks)
+        count += chunk.record_count;
+    return count;
+}
+
+Calibration RdtArchiveReader::calibration() const
+{
+    return Calibration::fromCountsPerUnit(m_count_per_force, m_count_per_torque);
+}
+
+std::size_t RdtArchiveReader::findChunk(SampleTime time) const
+{
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    auto chunk = std::lower_bound(m_chunks.begin(), m_chunks.end(), ns, [](const ArchiveChunkInfo &info, int64_t t)
+    {
+        return info.last_ns < t;
+    });
+    return static_cast<std::size_t>(chunk - m_chunks.begin());
+}
+
+void RdtArchiveReader::readChunk(std::size_t chunk, std::vector<RecordedResponse> &records) const
+{
+    const auto &info = m_chunks.at(chunk);
+    ChunkHeader header;
+    if(info.offset + sizeof(header) > m_size)
+        throw std::runtime_error("Corrupt archive chunk");
+    std::memcpy(&header, m_data + info.offset, sizeof(header));
+    if(header.magic != CHUNK_MAGIC || header.record_count != info.record_count)
+        throw std::runtime_error("Corrupt archive chunk");
+    records.resize(header.record_count);
+    std::span<RecordedResponse> out(records);
+
+    auto column_start = m_data + info.offset + sizeof(header);
+    for(std::size_t column = 0; column < COLUMN_COUNT; column++)
+    {
+        auto begin = column_start;
+        auto end = begin + header.column_size[column];
+        if(end > m_data + m_size)
+            throw std::runtime_error("Corrupt archive chunk");
+        column_start = end;
+        switch(column)
+        {
+        case TIMESTAMP:
+            decodeDelta(begin, end, out, header.first_ns, [](RecordedResponse &r, int64_t v) { r.received_ns = v; });
+            break;
+        case RDT_SEQUENCE:
+            decodeDelta(begin, end, out, 0, [](RecordedResponse &r, int64_t v) { r.response.rdt_package_sequence_index = uint32_t(v); });
+            break;
+        case FT_SEQUENCE:
+            decodeDelta(begin, end, out, 0, [](RecordedResponse &r, int64_t v) { r.response.ft_internal_sequence_index = uint32_t(v); });
+            break;
+        case STATUS:
+            decodeRuns(begin, end, out, [](RecordedResponse &r, uint64_t v) { r.response.status = uint32_t(v); });
+            break;
+        case FX:
+        case FY:
+        case FZ:
+        case TX:
+        case TY:
+        case TZ:
+            decodeDelta(begin, end, out, 0, [field = COUNT_FIELDS[column - FX]](RecordedResponse &r, int64_t v) { r.response.*field = int32_t(v); });
+            break;
+        case UNIT:
+            decodeRuns(begin, end, out, [](RecordedResponse &r, uint64_t v) { r.unit = uint32_t(v); });
+            break;
+        }
+    }
+}
+
+void RdtArchiveReader::readSamples(std::size_t chunk, uint32_t unit, std::vector<SensorSample> &samples) const
+{
+    std::vector<RecordedResponse> records;
+    readChunk(chunk, records);
+    std::vector<RTDResponse> responses;
+    responses.reserve(records.size());
+    samples.clear();
+    for(const auto &record : records)
+    {
+        if(record.unit != unit)
+            continue;
+        responses.push_back(record.response);
+        SensorSample sample;
+        sample.sequence = record.response.rdt_package_sequence_index;
+        sample.timestamp = SampleTime(std::chrono::duration_cast<SampleTime::duration>(std::chrono::nanoseconds(record.received_ns)));
+        samples.push_back(sample);
+    }
+    std::vector<std::array<double, 6>> loads(responses.size());
+    calibration().convert(responses, loads.data());
+    for(std::size_t i = 0; i < samples.size(); i++)
+        samples[i].load = loads[i];
+}
+
+void RdtArchiveReader::scan(const std::function<void(std::span<const RecordedResponse> records)> &visitor) const
+{
+    std::vector<RecordedResponse> records;
+    for(std::size_t chunk = 0; chunk < m_chunks.size(); chunk++)
+    {
+        readChunk(chunk, records);
+        visitor(records);
+    }
+}
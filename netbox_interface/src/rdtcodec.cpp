@@ -0,0 +1,64 @@
+#include "sensor_interface/rdtcodec.h"
+
+#include <cstring>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace estimation::sensor_interface;
+
+namespace {
+constexpr std::size_t VECTOR_SIZE = 16u;
+
+// Converts size bytes of big-endian 32-bit words to native order in place; size is a multiple of 4.
+void swapWords(unsigned char *data, std::size_t size)
+{
+    if constexpr(std::endian::native == std::endian::big)
+        return;
+    std::size_t i = 0;
+#if defined(__SSSE3__)
+    const auto reverse = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for(; i + VECTOR_SIZE <= size; i += VECTOR_SIZE)
+    {
+        auto words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_shuffle_epi8(words, reverse));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    for(; i + VECTOR_SIZE <= size; i += VECTOR_SIZE)
+    {
+        auto words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        // Swap the bytes of every 16-bit half, then the halves of every word.
+        words = _mm_or_si128(_mm_slli_epi16(words, 8), _mm_srli_epi16(words, 8));
+        words = _mm_shufflehi_epi16(_mm_shufflelo_epi16(words, 0xb1), 0xb1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), words);
+    }
+#elif defined(__ARM_NEON)
+    for(; i + VECTOR_SIZE <= size; i += VECTOR_SIZE)
+        vst1q_u8(data + i, vrev32q_u8(vld1q_u8(data + i)));
+#endif
+    for(; i < size; i += sizeof(uint32_t))
+    {
+        uint32_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        word = toBigEndian(word);
+        std::memcpy(data + i, &word, sizeof(word));
+    }
+}
+}
+
+std::size_t RdtCodec::decode(std::span<const unsigned char> payload, RTDResponse *responses)
+{
+    auto count = payload.size() / RTD_RESPONSE_SIZE;
+    if(count == 0u)
+        return 0u;
+    auto size = count * RTD_RESPONSE_SIZE;
+    // RTDResponse mirrors the wire record (asserted with the layout), so the records only need their words swapped.
+    std::memcpy(responses, payload.data(), size);
+    swapWords(reinterpret_cast<unsigned char*>(responses), size);
+    return count;
+}
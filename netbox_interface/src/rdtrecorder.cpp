@@ -0,0 +1,263 @@
+#include "sensor_interface/rdtrecorder.h"
+#include "sensor_interface/sensorcontroller.h"
+
+#include <mutex>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace estimation::sensor_interface;
+
+namespace {
+std::runtime_error fileError(const std::string &what, const std::string &path, int error = errno)
+{
+    return std::runtime_error(what + " " + path + ": " + std::strerror(error));
+}
+
+int64_t toNanoseconds(SampleTime time)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+SampleTime fromNanoseconds(int64_t nanoseconds)
+{
+    return SampleTime(std::chrono::duration_cast<SampleTime::duration>(std::chrono::nanoseconds(nanoseconds)));
+}
+}
+
+RecordQueue::RecordQueue(std::size_t capacity)
+: m_open(true)
+, m_queue(capacity)
+, m_dropped(0u)
+{
+}
+
+void RecordQueue::push(std::span<const RTDResponse> batch, SampleTime received, uint32_t unit)
+{
+    RecordedResponse entry;
+    entry.received_ns = toNanoseconds(received);
+    entry.unit = unit;
+    // The queue has a single producer slot; controllers on different threads take turns through the lock.
+    std::lock_guard<std::mutex> l(m_producer_lock);
+    if(!m_open)
+        return;
+    for(const auto &response : batch)
+    {
+        entry.response = response;
+        if(!m_queue.tryPush(entry))
+            m_dropped.fetch_add(1u, std::memory_order_relaxed);
+    }
+}
+
+bool RecordQueue::tryPop(RecordedResponse &record)
+{
+    return m_queue.tryPop(record);
+}
+
+RecordedResponse *RecordQueue::front()
+{
+    return m_queue.front();
+}
+
+void RecordQueue::pop()
+{
+    m_queue.pop();
+}
+
+void RecordQueue::close()
+{
+    std::lock_guard<std::mutex> l(m_producer_lock);
+    m_open = false;
+}
+
+uint64_t RecordQueue::dropped() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+RdtRecorder::RdtRecorder(const std::string &path, uint64_t capacity, std::size_t queue_capacity)
+: m_fd(-1)
+, m_capacity(capacity)
+, m_header(nullptr)
+, m_records(nullptr)
+, m_mapping_size(sizeof(RecordingHeader) + capacity * sizeof(RecordedResponse))
+, m_queue(std::make_shared<RecordQueue>(queue_capacity))
+, m_running(true)
+, m_recorded(0u)
+, m_dropped(0u)
+{
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(m_fd < 0)
+        throw fileError("Unable to create recording", path);
+    // Reserve the blocks up front so a full disk fails here and not on a page fault in the writer. Only file systems
+    // that cannot preallocate get a sparse file instead. posix_fallocate() returns its error rather than setting errno.
+    auto error = ::posix_fallocate(m_fd, 0, m_mapping_size);
+    if(error == EOPNOTSUPP || error == EINVAL)
+        error = ::ftruncate(m_fd, m_mapping_size) == 0 ? 0 : errno;
+    if(error != 0)
+    {
+        ::close(m_fd);
+        throw fileError("Unable to size recording", path, error);
+    }
+    auto mapping = ::mmap(nullptr, m_mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if(mapping == MAP_FAILED)
+    {
+        ::close(m_fd);
+        throw fileError("Unable to map recording", path);
+    }
+    m_header = static_cast<RecordingHeader*>(mapping);
+    m_records = reinterpret_cast<RecordedResponse*>(static_cast<unsigned char*>(mapping) + sizeof(RecordingHeader));
+    std::memset(m_header, 0, sizeof(RecordingHeader));
+    m_header->magic = RecordingHeader::MAGIC;
+    m_header->version = 1u;
+    m_header->record_size = sizeof(RecordedResponse);
+    m_header->capacity = capacity;
+    m_writer = std::thread(&RdtRecorder::write, this);
+}
+
+RdtRecorder::~RdtRecorder()
+{
+    close();
+}
+
+void RdtRecorder::attach(SensorController &controller, uint32_t unit)
+{
+    controller.addRawBatchListener([queue = m_queue, unit](std::span<const RTDResponse> batch, SampleTime received)
+    {
+        queue->push(batch, received, unit);
+    });
+}
+
+void RdtRecorder::record(std::span<const RTDResponse> batch, SampleTime received, uint32_t unit)
+{
+    m_queue->push(batch, received, unit);
+}
+
+uint64_t RdtRecorder::recorded() const
+{
+    return m_recorded.load(std::memory_order_relaxed);
+}
+
+uint64_t RdtRecorder::dropped() const
+{
+    return m_queue->dropped() + m_dropped.load(std::memory_order_relaxed);
+}
+
+void RdtRecorder::close()
+{
+    if(!m_running.exchange(false))
+        return;
+    m_queue->close();
+    m_writer.join();
+    m_header->count = recorded();
+    m_header->overflowed = dropped();
+    ::msync(m_header, m_mapping_size, MS_SYNC);
+    ::munmap(m_header, m_mapping_size);
+    ::close(m_fd);
+    m_header = nullptr;
+    m_records = nullptr;
+}
+
+void RdtRecorder::write()
+{
+    uint64_t count = 0u;
+    while(true)
+    {
+        auto running = m_running.load();
+        std::size_t written = 0u;
+        while(auto entry = m_queue->front())
+        {
+            if(count < m_capacity)
+                m_records[count++] = *entry;
+            else
+                m_dropped.fetch_add(1u, std::memory_order_relaxed);
+            m_queue->pop();
+            written++;
+        }
+        m_recorded.store(count, std::memory_order_relaxed);
+        m_header->count = count;
+        if(!running)
+            return;
+        if(written == 0u)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+RdtRecordingReader::RdtRecordingReader(const std::string &path)
+: m_fd(-1)
+, m_mapping(nullptr)
+, m_mapping_size(0u)
+, m_header(nullptr)
+{
+    m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(m_fd < 0)
+        throw fileError("Unable to open recording", path);
+    struct stat status;
+    if(::fstat(m_fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(RecordingHeader)))
+    {
+        ::close(m_fd);
+        throw std::runtime_error("Recording " + path + " is truncated");
+    }
+    m_mapping_size = status.st_size;
+    m_mapping = ::mmap(nullptr, m_mapping_size, PROT_READ, MAP_SHARED, m_fd, 0);
+    if(m_mapping == MAP_FAILED)
+    {
+        ::close(m_fd);
+        throw fileError("Unable to map recording", path);
+    }
+    ::madvise(const_cast<void*>(m_mapping), m_mapping_size, MADV_SEQUENTIAL);
+    m_header = static_cast<const RecordingHeader*>(m_mapping);
+    auto available = (m_mapping_size - sizeof(RecordingHeader)) / sizeof(RecordedResponse);
+    if(m_header->magic != RecordingHeader::MAGIC || m_header->record_size != sizeof(RecordedResponse) || m_header->count > available)
+    {
+        ::munmap(const_cast<void*>(m_mapping), m_mapping_size);
+        ::close(m_fd);
+        throw std::runtime_error(path + " is not a Netbox RDT recording");
+    }
+}
+
+RdtRecordingReader::~RdtRecordingReader()
+{
+    ::munmap(const_cast<void*>(m_mapping), m_mapping_size);
+    ::close(m_fd);
+}
+
+std::span<const RecordedResponse> RdtRecordingReader::records() const
+{
+    auto first = reinterpret_cast<const RecordedResponse*>(static_cast<const unsigned char*>(m_mapping) + sizeof(RecordingHeader));
+    return {first, m_header->count};
+}
+
+void RdtRecordingReader::replay(SensorController &controller, uint32_t unit, double speed) const
+{
+    auto all = records();
+    std::vector<RTDResponse> batch;
+    batch.reserve(RTD_MAX_DATAGRAM_SIZE / RTD_RESPONSE_SIZE);
+    auto wall_start = std::chrono::steady_clock::now();
+    int64_t recorded_start = all.empty() ? 0 : all.front().received_ns;
+    std::size_t i = 0;
+    while(i < all.size())
+    {
+        auto received_ns = all[i].received_ns;
+        batch.clear();
+        for(; i < all.size() && all[i].received_ns == received_ns; i++)
+        {
+            if(all[i].unit == unit)
+                batch.push_back(all[i].response);
+        }
+        if(batch.empty())
+            continue;
+        if(speed > 0.0)
+        {
+            auto offset = std::chrono::nanoseconds(static_cast<int64_t>((received_ns - recorded_start) / speed));
+            std::this_thread::sleep_until(wall_start + offset);
+        }
+        controller.ingest(batch, fromNanoseconds(received_ns));
+    }
+}
@@ -0,0 +1,421 @@
+#include "sensor_interface/remotesamplestream.h"
+#include "sensor_interface/sensorcontroller.h"
+
+#include <bit>
+#include <array>
+#include <cerrno>
+#include <limits>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+using namespace estimation::sensor_interface;
+
+namespace {
+std::runtime_error socketError(const std::string &what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+in_addr parseAddress(const std::string &address)
+{
+    in_addr parsed{};
+    if(::inet_pton(AF_INET, address.c_str(), &parsed) != 1)
+        throw std::runtime_error("Invalid IPv4 address " + address);
+    return parsed;
+}
+
+bool isMulticast(in_addr address)
+{
+    return IN_MULTICAST(ntohl(address.s_addr));
+}
+
+// Unsigned integer of the same width as T, for byte-order independent encoding.
+template<typename T>
+using Bits = std::conditional_t<sizeof(T) == 8u, uint64_t,
+             std::conditional_t<sizeof(T) == 4u, uint32_t,
+             std::conditional_t<sizeof(T) == 2u, uint16_t, uint8_t>>>;
+
+template<typename T>
+unsigned char *store(unsigned char *out, T value)
+{
+    auto bits = std::bit_cast<Bits<T>>(value);
+    for(std::size_t i = 0; i < sizeof(T); i++)
+        out[i] = static_cast<unsigned char>(bits >> (8u * i));
+    return out + sizeof(T);
+}
+
+template<typename T>
+const unsigned char *load(const unsigned char *in, T &value)
+{
+    Bits<T> bits = 0;
+    for(std::size_t i = 0; i < sizeof(T); i++)
+        bits |= static_cast<Bits<T>>(static_cast<Bits<T>>(in[i]) << (8u * i));
+    value = std::bit_cast<T>(bits);
+    return in + sizeof(T);
+}
+
+int64_t nanosecondsSinceEpoch(SampleTime time)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+}
+
+struct RemoteSamplePublisher::Sender
+{
+    RemoteStreamSettings settings;
+    int fd = -1;
+    sockaddr_in destination;
+
+    std::mutex lock;
+    std::condition_variable batch_started;
+    bool running = true;
+
+    std::array<unsigned char, RemoteStreamFormat::MAX_DATAGRAM_SIZE> datagram{};
+    std::size_t count = 0;
+    uint64_t first_sequence = 0;
+    int64_t first_timestamp = 0;
+    std::chrono::steady_clock::time_point deadline;
+    uint64_t datagram_sequence = 0;
+
+    std::atomic<uint64_t> datagrams{0};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> dropped{0};
+
+    ~Sender()
+    {
+        ::close(fd);
+    }
+
+    // Receive thread.
+    void add(const SensorSample &sample)
+    {
+        std::lock_guard<std::mutex> l(lock);
+        if(!running)
+            return;
+        auto timestamp = nanosecondsSinceEpoch(sample.timestamp);
+        if(count > 0u && (sample.sequence <= first_sequence || sample.sequence - first_sequence > std::numeric_limits<uint16_t>::max() ||
+                          timestamp < first_timestamp || timestamp - first_timestamp > std::numeric_limits<uint32_t>::max()))
+            send();
+        if(count == 0u)
+        {
+            first_sequence = sample.sequence;
+            first_timestamp = timestamp;
+            deadline = std::chrono::steady_clock::now() + settings.latency_bound;
+            batch_started.notify_one();
+        }
+
+        auto out = datagram.data() + RemoteStreamFormat::HEADER_SIZE + count * RemoteStreamFormat::RECORD_SIZE;
+        out = store(out, static_cast<uint16_t>(sample.sequence - first_sequence));
+        out = store(out, static_cast<uint32_t>(timestamp - first_timestamp));
+        for(auto value : sample.load)
+            out = store(out, static_cast<float>(value));
+        if(++count == settings.batch_size)
+            send();
+    }
+
+    // Called with lock held and count > 0.
+    void send()
+    {
+        auto out = store(datagram.data(), RemoteStreamFormat::MAGIC);
+        out = store(out, RemoteStreamFormat::VERSION);
+        out = store(out, static_cast<uint8_t>(settings.filtered ? RemoteStreamFormat::FILTERED : 0u));
+        out = store(out, static_cast<uint16_t>(count));
+        out = store(out, settings.stream_id);
+        out = store(out, datagram_sequence++);
+        out = store(out, first_sequence);
+        store(out, first_timestamp);
+
+        auto size = RemoteStreamFormat::HEADER_SIZE + count * RemoteStreamFormat::RECORD_SIZE;
+        if(::sendto(fd, datagram.data(), size, MSG_DONTWAIT, reinterpret_cast<const sockaddr*>(&destination), sizeof(destination)) ==
+           static_cast<ssize_t>(size))
+        {
+            datagrams.fetch_add(1u, std::memory_order_relaxed);
+            samples.fetch_add(count, std::memory_order_relaxed);
+        }
+        else
+        {
+            dropped.fetch_add(1u, std::memory_order_relaxed);
+        }
+        count = 0u;
+    }
+
+    void flushLoop()
+    {
+        std::unique_lock<std::mutex> l(lock);
+        while(running)
+        {
+            if(count == 0u)
+                batch_started.wait(l);
+            else if(std::chrono::steady_clock::now() >= deadline)
+                send();
+            else
+                batch_started.wait_until(l, deadline);
+        }
+    }
+};
+
+RemoteSamplePublisher::RemoteSamplePublisher(SensorController &controller, const RemoteStreamSettings &settings)
+: m_sender(std::make_shared<Sender>())
+{
+    auto &sender = *m_sender;
+    sender.settings = settings;
+    sender.settings.batch_size = std::clamp<std::size_t>(settings.batch_size, 1u, RemoteStreamFormat::MAX_BATCH_SIZE);
+
+    sender.destination = {};
+    sender.destination.sin_family = AF_INET;
+    sender.destination.sin_port = htons(settings.port);
+    sender.destination.sin_addr = parseAddress(settings.address);
+
+    sender.fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+    if(sender.fd < 0)
+        throw socketError("Unable to create UDP socket");
+    if(isMulticast(sender.destination.sin_addr))
+    {
+        unsigned char ttl = static_cast<unsigned char>(std::clamp(settings.multicast_ttl, 0, 255));
+        unsigned char loopback = settings.multicast_loopback ? 1u : 0u;
+        ::setsockopt(sender.fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+        ::setsockopt(sender.fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loopback, sizeof(loopback));
+        if(!settings.interface_address.empty())
+        {
+            auto interface = parseAddress(settings.interface_address);
+            if(::setsockopt(sender.fd, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface)) != 0)
+                throw socketError("Unable to select multicast interface " + settings.interface_address);
+        }
+    }
+
+    m_flush_thread = std::thread([sender = m_sender]()
+    {
+        sender->flushLoop();
+    });
+
+    // The listeners keep the sender alive; once this publisher is gone they return without touching the socket.
+    auto listener = [sender = m_sender](const SensorSample &sample)
+    {
+        sender->add(sample);
+    };
+    if(settings.filtered)
+        controller.addFilteredSampleListener(listener);
+    else
+        controller.addSensorSampleListener(listener);
+}
+
+RemoteSamplePublisher::~RemoteSamplePublisher()
+{
+    {
+        std::lock_guard<std::mutex> l(m_sender->lock);
+        if(m_sender->count > 0u)
+            m_sender->send();
+        m_sender->running = false;
+        m_sender->batch_started.notify_one();
+    }
+    m_flush_thread.join();
+}
+
+void RemoteSamplePublisher::flush()
+{
+    std::lock_guard<std::mutex> l(m_sender->lock);
+    if(m_sender->count > 0u)
+        m_sender->send();
+}
+
+RemoteStreamStatistics RemoteSamplePublisher::statistics() const
+{
+    RemoteStreamStatistics statistics;
+    statistics.datagrams = m_sender->datagrams.load(std::memory_order_relaxed);
+    statistics.samples = m_sender->samples.load(std::memory_order_relaxed);
+    statistics.dropped = m_sender->dropped.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+RemoteSampleSubscriber::RemoteSampleSubscriber(const RemoteStreamSettings &settings)
+: m_settings(settings)
+, m_fd(-1)
+, m_waiters(0u)
+, m_filtered(false)
+, m_datagrams(0u)
+, m_samples(0u)
+, m_dropped(0u)
+, m_malformed(0u)
+, m_next_datagram(0u)
+, m_running(true)
+{
+    auto address = parseAddress(settings.address);
+    m_fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+    if(m_fd < 0)
+        throw socketError("Unable to create UDP socket");
+
+    // Several subscribers on one host share the group's port.
+    int reuse = 1;
+    ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#ifdef SO_REUSEPORT
+    ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse));
+#endif
+    timeval timeout{0, 100000};
+    ::setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(settings.port);
+    local.sin_addr = address;
+    if(::bind(m_fd, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0)
+    {
+        auto error = socketError("Unable to bind UDP " + settings.address + ":" + std::to_string(settings.port));
+        ::close(m_fd);
+        throw error;
+    }
+    if(isMulticast(address))
+    {
+        ip_mreq membership{};
+        membership.imr_multiaddr = address;
+        membership.imr_interface.s_addr = htonl(INADDR_ANY);
+        if(!settings.interface_address.empty())
+            membership.imr_interface = parseAddress(settings.interface_address);
+        if(::setsockopt(m_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0)
+        {
+            auto error = socketError("Unable to join multicast group " + settings.address);
+            ::close(m_fd);
+            throw error;
+        }
+    }
+
+    m_receive_thread = std::thread(&RemoteSampleSubscriber::receiveLoop, this);
+}
+
+RemoteSampleSubscriber::~RemoteSampleSubscriber()
+{
+    m_running = false;
+    m_receive_thread.join();
+    ::close(m_fd);
+}
+
+void RemoteSampleSubscriber::addSampleListener(SampleListener listener)
+{
+    std::lock_guard<std::mutex> l(m_listener_lock);
+    m_listeners.push_back(listener);
+}
+
+bool RemoteSampleSubscriber::isFiltered() const
+{
+    return m_filtered.load(std::memory_order_relaxed);
+}
+
+SensorSample RemoteSampleSubscriber::latestSample() const
+{
+    return m_latest_sample.load();
+}
+
+std::optional<SensorSample> RemoteSampleSubscriber::waitForNext(uint64_t last_sequence, std::chrono::nanoseconds timeout)
+{
+    auto sample = m_latest_sample.load();
+    if(sample.sequence > last_sequence)
+        return sample;
+    std::unique_lock<std::mutex> l(m_wait_lock);
+    m_waiters++;
+    bool published = m_sample_published.wait_for(l, timeout, [&]()
+    {
+        sample = m_latest_sample.load();
+        return sample.sequence > last_sequence;
+    });
+    m_waiters--;
+    if(!published)
+        return std::nullopt;
+    return sample;
+}
+
+RemoteStreamStatistics RemoteSampleSubscriber::statistics() const
+{
+    RemoteStreamStatistics statistics;
+    statistics.datagrams = m_datagrams.load(std::memory_order_relaxed);
+    statistics.samples = m_samples.load(std::memory_order_relaxed);
+    statistics.dropped = m_dropped.load(std::memory_order_relaxed);
+    statistics.malformed = m_malformed.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+void RemoteSampleSubscriber::receiveLoop()
+{
+    std::array<unsigned char, RemoteStreamFormat::MAX_DATAGRAM_SIZE + 1u> buffer;
+    while(m_running)
+    {
+        auto received = ::recv(m_fd, buffer.data(), buffer.size(), 0);
+        if(received > 0)
+            receiveDatagram(buffer.data(), static_cast<std::size_t>(received));
+    }
+}
+
+void RemoteSampleSubscriber::receiveDatagram(const unsigned char *data, std::size_t size)
+{
+    uint32_t magic = 0, stream_id = 0;
+    uint8_t version = 0, flags = 0;
+    uint16_t count = 0;
+    uint64_t datagram_sequence = 0, first_sequence = 0;
+    int64_t first_timestamp = 0;
+    if(size >= RemoteStreamFormat::HEADER_SIZE)
+    {
+        auto in = load(data, magic);
+        in = load(in, version);
+        in = load(in, flags);
+        in = load(in, count);
+        in = load(in, stream_id);
+        in = load(in, datagram_sequence);
+        in = load(in, first_sequence);
+        load(in, first_timestamp);
+    }
+    if(magic != RemoteStreamFormat::MAGIC || version != RemoteStreamFormat::VERSION ||
+       size != RemoteStreamFormat::HEADER_SIZE + count * RemoteStreamFormat::RECORD_SIZE)
+    {
+        m_malformed.fetch_add(1u, std::memory_order_relaxed);
+        return;
+    }
+    if(stream_id != m_settings.stream_id)
+        return;
+
+    // A sequence that goes backwards means the publisher restarted; count nothing as lost.
+    if(datagram_sequence > m_next_datagram && m_datagrams.load(std::memory_order_relaxed) > 0u)
+        m_dropped.fetch_add(datagram_sequence - m_next_datagram, std::memory_order_relaxed);
+    m_next_datagram = datagram_sequence + 1u;
+    m_filtered.store((flags & RemoteStreamFormat::FILTERED) != 0u, std::memory_order_relaxed);
+
+    auto now = std::chrono::system_clock::now();
+    auto in = data + RemoteStreamFormat::HEADER_SIZE;
+    std::lock_guard<std::mutex> l(m_listener_lock);
+    for(uint16_t i = 0; i < count; i++)
+    {
+        uint16_t sequence_delta = 0;
+        uint32_t timestamp_offset = 0;
+        in = load(in, sequence_delta);
+        in = load(in, timestamp_offset);
+
+        SensorSample sample;
+        sample.sequence = first_sequence + sequence_delta;
+        sample.timestamp = SampleTime(std::chrono::duration_cast<SampleTime::duration>(
+            std::chrono::nanoseconds(first_timestamp + static_cast<int64_t>(timestamp_offset))));
+        sample.latency = now - sample.timestamp;
+        for(auto &value : sample.load)
+        {
+            float channel = 0.0f;
+            in = load(in, channel);
+            value = channel;
+        }
+        m_latest_sample.store(sample);
+        for(const auto &listener : m_listeners)
+            listener(sample);
+    }
+    m_datagrams.fetch_add(1u, std::memory_order_relaxed);
+    m_samples.fetch_add(count, std::memory_order_relaxed);
+
+    // Orders the sample store before the waiter count load, pairing with waitForNext()'s increment before it reads.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(m_waiters.load(std::memory_order_relaxed) > 0u)
+    {
+        std::lock_guard<std::mutex> wait_lock(m_wait_lock);
+        m_sample_published.notify_all();
+    }
+}
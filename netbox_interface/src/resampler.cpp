@@ -0,0 +1,192 @@
+#include "sensor_interface/resampler.h"
+#include "sensor_interface/sensorcontroller.h"
+
+#include <algorithm>
+
+using namespace estimation::sensor_interface;
+
+namespace {
+constexpr std::size_t REFRESH_BATCH = 256u;
+
+double seconds(SampleTime::duration duration)
+{
+    return std::chrono::duration<double>(duration).count();
+}
+
+Eigen::Map<const Channels> channels(const SensorSample &sample)
+{
+    return Eigen::Map<const Channels>(sample.load.data());
+}
+}
+
+Resampler::Resampler(const SensorController &controller, const ResamplerSettings &settings)
+: m_controller(controller)
+, m_settings(settings)
+, m_window(std::max<std::size_t>(settings.capacity, 4u))
+, m_first(0u)
+, m_size(0u)
+, m_cursor(0u)
+, m_scratch(REFRESH_BATCH)
+, m_output_running(false)
+, m_missed_ticks(0u)
+, m_late_ticks(0u)
+{
+    // Older samples would be dropped from the window straight away.
+    auto next = controller.sampleHistory().nextSequence();
+    m_cursor = next > m_window.size() ? next - m_window.size() : 1u;
+}
+
+Resampler::~Resampler()
+{
+    stopOutput();
+}
+
+std::optional<ResampledSample> Resampler::sampleAt(SampleTime time)
+{
+    std::lock_guard<std::mutex> l(m_lock);
+    refresh();
+    if(m_size == 0u || time < at(0u).timestamp)
+        return std::nullopt;
+
+    ResampledSample result;
+    result.timestamp = time;
+    const auto &newest = at(m_size - 1u);
+    if(time >= newest.timestamp)
+    {
+        if(time - newest.timestamp > m_settings.max_extrapolation)
+            return std::nullopt;
+        result.sequence = newest.sequence;
+        result.load = newest.load;
+        if(time == newest.timestamp)
+            return result;
+        result.extrapolated = true;
+        // Continue the slope from the last sample with an earlier timestamp; equal ones remain before the sample period
+        // is known or after the clock steps back.
+        for(std::size_t i = m_size - 1u; i-- > 0u;)
+        {
+            const auto &previous = at(i);
+            if(previous.timestamp == newest.timestamp)
+                continue;
+            Channels slope = (channels(newest) - channels(previous)) / seconds(newest.timestamp - previous.timestamp);
+            Eigen::Map<Channels>(result.load.data()) = channels(newest) + slope * seconds(time - newest.timestamp);
+            break;
+        }
+        return result;
+    }
+
+    // First sample after time; the window is sorted by timestamp, and at(0) <= time < newest here.
+    std::size_t low = 1u;
+    std::size_t high = m_size - 1u;
+    while(low < high)
+    {
+        auto middle = low + (high - low) / 2u;
+        if(at(middle).timestamp > time)
+            high = middle;
+        else
+            low = middle + 1u;
+    }
+    auto j = low;
+    auto i = j - 1u;
+    const auto &before = at(i);
+    const auto &after = at(j);
+    auto h = seconds(after.timestamp - before.timestamp);
+    auto s = seconds(time - before.timestamp) / h;
+    result.sequence = before.sequence;
+
+    Eigen::Map<Channels> load(result.load.data());
+    if(m_settings.interpolation == Interpolation::LINEAR)
+    {
+        load = channels(before) + (channels(after) - channels(before)) * s;
+        return result;
+    }
+
+    Channels secant = (channels(after) - channels(before)) / h;
+    Channels tangent_before = secant;
+    Channels tangent_after = secant;
+    if(i > 0u)
+        tangent_before = (channels(after) - channels(at(i - 1u))) / seconds(after.timestamp - at(i - 1u).timestamp);
+    if(j + 1u < m_size)
+        tangent_after = (channels(at(j + 1u)) - channels(before)) / seconds(at(j + 1u).timestamp - before.timestamp);
+    auto s2 = s * s;
+    auto s3 = s2 * s;
+    load = (2.0 * s3 - 3.0 * s2 + 1.0) * channels(before) + (s3 - 2.0 * s2 + s) * h * tangent_before +
+           (-2.0 * s3 + 3.0 * s2) * channels(after) + (s3 - s2) * h * tangent_after;
+    return result;
+}
+
+void Resampler::startOutput(std::chrono::nanoseconds period, OutputListener listener, std::chrono::nanoseconds delay)
+{
+    stopOutput();
+    m_output_running = true;
+    m_output_thread = std::thread([this, period, listener, delay]()
+    {
+        auto steady_start = std::chrono::steady_clock::now();
+        auto system_start = std::chrono::system_clock::now();
+        for(int64_t tick = 1; m_output_running; tick++)
+        {
+            auto deadline = steady_start + tick * period;
+            std::this_thread::sleep_until(deadline);
+            // Skip ticks the thread slept through instead of delivering them in a burst.
+            auto behind = (std::chrono::steady_clock::now() - deadline) / period;
+            if(behind > 0)
+            {
+                m_late_ticks.fetch_add(static_cast<uint64_t>(behind), std::memory_order_relaxed);
+                tick += behind;
+            }
+            auto time = system_start + std::chrono::duration_cast<SampleTime::duration>(tick * period);
+            auto sample = sampleAt(time - std::chrono::duration_cast<SampleTime::duration>(delay));
+            if(!sample)
+                m_missed_ticks.fetch_add(1u, std::memory_order_relaxed);
+            listener(time, sample);
+        }
+    });
+}
+
+void Resampler::stopOutput()
+{
+    m_output_running = false;
+    if(m_output_thread.joinable())
+        m_output_thread.join();
+}
+
+uint64_t Resampler::missedTicks() const
+{
+    return m_missed_ticks.load(std::memory_order_relaxed);
+}
+
+uint64_t Resampler::lateTicks() const
+{
+    return m_late_ticks.load(std::memory_order_relaxed);
+}
+
+void Resampler::refresh()
+{
+    while(true)
+    {
+        auto count = m_controller.readSamplesSince(m_cursor, m_scratch);
+        for(std::size_t i = 0; i < count; i++)
+        {
+            auto sample = m_scratch[i];
+            // Keep the window sorted even if the system clock steps back.
+            if(m_size > 0u)
+                sample.timestamp = std::max(sample.timestamp, at(m_size - 1u).timestamp);
+            if(m_size < m_window.size())
+            {
+                m_window[(m_first + m_size) % m_window.size()] = sample;
+                m_size++;
+            }
+            else
+            {
+                m_window[m_first] = sample;
+                m_first = (m_first + 1u) % m_window.size();
+            }
+        }
+        if(count < m_scratch.size())
+            return;
+    }
+}
+
+const SensorSample &Resampler::at(std::size_t index) const
+{
+    return m_window[(m_first + index) % m_window.size()];
+}
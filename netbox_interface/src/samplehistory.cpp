@@ -0,0 +1,83 @@
+#include "sensor_interface/samplehistory.h"
+
+#include <bit>
+#include <algorithm>
+
+using namespace estimation::sensor_interface;
+
+SampleHistory::SampleHistory(std::size_t capacity)
+: m_mask(std::bit_ceil(std::max<std::size_t>(capacity, 2u)) - 1u)
+, m_storage(std::make_unique<Slot[]>(m_mask + 1u))
+, m_slots(m_storage.get())
+, m_head(&m_local_head)
+, m_local_head(1u)
+{
+}
+
+SampleHistory::SampleHistory(Slot *slots, std::size_t capacity, std::atomic<uint64_t> *head)
+: m_mask(capacity - 1u)
+, m_slots(slots)
+, m_head(head)
+, m_local_head(0u)
+{
+}
+
+std::size_t SampleHistory::capacity() const
+{
+    return m_mask + 1u;
+}
+
+uint64_t SampleHistory::nextSequence() const
+{
+    return m_head->load(std::memory_order_acquire);
+}
+
+uint64_t SampleHistory::push(const SensorSample &sample)
+{
+    auto sequence = m_head->load(std::memory_order_relaxed);
+    auto &slot = m_slots[sequence & m_mask];
+    slot.version.store(2u * sequence + 1u, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.sample = sample;
+    slot.sample.sequence = sequence;
+    slot.version.store(2u * sequence + 2u, std::memory_order_release);
+    m_head->store(sequence + 1u, std::memory_order_release);
+    return sequence;
+}
+
+std::size_t SampleHistory::readSince(uint64_t &cursor, std::span<SensorSample> samples) const
+{
+    std::size_t count = 0;
+    auto head = m_head->load(std::memory_order_acquire);
+    if(cursor > head)
+        cursor = head;
+    if(cursor == 0u)
+        cursor = 1u;
+    while(cursor < head && count < samples.size())
+    {
+        auto oldest = head > capacity() + 1u ? head - capacity() : 1u;
+        if(cursor < oldest)
+            cursor = oldest;
+        if(readSlot(cursor, samples[count]))
+        {
+            cursor++;
+            count++;
+            continue;
+        }
+        // The slot was recycled while we read it, so this sample is gone.
+        cursor++;
+        head = m_head->load(std::memory_order_acquire);
+    }
+    return count;
+}
+
+bool SampleHistory::readSlot(uint64_t sequence, SensorSample &sample) const
+{
+    const auto &slot = m_slots[sequence & m_mask];
+    auto before = slot.version.load(std::memory_order_acquire);
+    if(before != 2u * sequence + 2u)
+        return false;
+    sample = slot.sample;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.version.load(std::memory_order_relaxed) == before;
+}
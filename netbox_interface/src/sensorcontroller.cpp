@@ -4,29 +4,93 @@
 
 using namespace estimation::sensor_interface;
 
-SensorController::SensorController(const std::string &hostname, uint32_t port)
+namespace {
+constexpr uint32_t RAW_STREAM = 0u;
+constexpr uint32_t FILTERED_STREAM = 1u;
+// Sample index advances beyond this between datagrams are stream restarts, not a measure of the sample period.
+constexpr uint32_t MAX_PERIOD_INDEX_ADVANCE = 1u << 16;
+}
+
+SensorController::SensorController(const std::string &hostname, uint32_t port, const NetboxStreamSettings &settings,
+                                   std::size_t history_capacity)
 : m_port(port)
 , m_hostname(hostname)
+, m_settings(settings)
+, m_nominal_period(0)
+, m_estimated_period(0.0)
 , m_sensor_connected(false)
-, m_count_per_force(1000000u)
-, m_count_per_torque(1000000u)
-{
-    SensorSnapshot s;
-    s.fx = 0.0;
-    s.fy = 0.0;
-    s.fz = 0.0;
-    s.tx = 0.0;
-    s.ty = 0.0;
-    s.tz = 0.0;
-    m_sensor_load_snapshot.store(s);
+, m_calibration(Calibration::fromCountsPerUnit(1000000.0, 1000000.0))
+, m_tool_transform(Eigen::Isometry3d::Identity())
+, m_waiters(0u)
+, m_awaiters(nullptr)
+, m_history(history_capacity)
+, m_statistics(nullptr)
+{
     startSensorInterface();
 }
 
+SensorController::SensorController(std::size_t history_capacity)
+: m_port(0u)
+, m_nominal_period(0)
+, m_estimated_period(0.0)
+, m_sensor_connected(false)
+, m_calibration(Calibration::fromCountsPerUnit(1000000.0, 1000000.0))
+, m_tool_transform(Eigen::Isometry3d::Identity())
+, m_waiters(0u)
+, m_awaiters(nullptr)
+, m_history(history_capacity)
+, m_statistics(nullptr)
+{
+}
+
+SensorController::~SensorController()
+{
+    // Stop the owned client first: its receive thread, and the connectedChanged(false) from stopping it, call into
+    // the listeners declared after it.
+    std::unique_lock<std::shared_mutex> l(m_interface_lock);
+    m_netbox_rdt.reset();
+}
+
+void SensorController::attach(NetboxRdtClient &client, uint32_t unit)
+{
+    client.setSensorBatchListener([this](std::span<const RTDResponse> batch, SampleTime received)
+    {
+        ingest(batch, received);
+    }, unit);
+    client.addConnectionListener([this](bool connected)
+    {
+        connectionChanged(connected);
+    });
+    m_statistics = &client.statistics(unit);
+}
+
+StreamStatisticsSnapshot SensorController::streamStatistics() const
+{
+    auto statistics = m_statistics.load();
+    if(!statistics)
+        return {};
+    return statistics->snapshot();
+}
+
 bool SensorController::hasConnectedSensor()
 {
     return m_sensor_connected;
 }
 
+void SensorController::addConnectionListener(SensorController::ConnectionListener listener)
+{
+    std::lock_guard<std::mutex> l(m_listener_lock);
+    m_connection_listeners.push_back(listener);
+}
+
+void SensorController::connectionChanged(bool connected)
+{
+    m_sensor_connected = connected;
+    std::lock_guard<std::mutex> l(m_listener_lock);
+    for(const auto &listener : m_connection_listeners)
+        listener(connected);
+}
+
 void SensorController::setCalibrationBias(const Eigen::Vector3d &force_bias, const Eigen::Vector3d &torque_bias)
 {
     std::unique_lock<std::shared_mutex> l(m_bias_lock);
@@ -36,8 +100,31 @@ void SensorController::setCalibrationBias(const Eigen::Vector3d &force_bias, con
 
 void SensorController::setCountPerForceTorque(uint32_t fcount, uint32_t tcount)
 {
-    m_count_per_force = fcount;
-    m_count_per_torque = tcount;
+    auto calibration = Calibration::fromCountsPerUnit(fcount, tcount);
+    std::unique_lock<std::shared_mutex> l(m_calibration_lock);
+    calibration.setToolTransform(m_tool_transform);
+    m_calibration = calibration;
+}
+
+void SensorController::setCalibrationMatrix(const Matrix6d &counts_to_wrench)
+{
+    auto calibration = Calibration::fromMatrix(counts_to_wrench);
+    std::unique_lock<std::shared_mutex> l(m_calibration_lock);
+    calibration.setToolTransform(m_tool_transform);
+    m_calibration = calibration;
+}
+
+void SensorController::setToolTransform(const Eigen::Isometry3d &tool_from_sensor)
+{
+    std::unique_lock<std::shared_mutex> l(m_calibration_lock);
+    m_tool_transform = tool_from_sensor;
+    m_calibration.setToolTransform(tool_from_sensor);
+}
+
+Calibration SensorController::calibration() const
+{
+    std::shared_lock<std::shared_mutex> l(m_calibration_lock);
+    return m_calibration;
 }
 
 Eigen::Vector3d SensorController::forceBias() const
@@ -54,19 +141,123 @@ Eigen::Vector3d SensorController::torqueBias() const
 
 std::pair<Eigen::Vector3d, Eigen::Vector3d> SensorController::currentRawLoad()
 {
-    auto data = m_sensor_load_snapshot.load();
-    Eigen::Vector3d force(data.fx, data.fy, data.fz);
-    Eigen::Vector3d torque(data.tx, data.ty, data.tz);
-    return std::make_pair(force, torque);
+    auto data = m_latest_sample.load();
+    return std::make_pair(data.force(), data.torque());
 }
 
 std::pair<Eigen::Vector3d, Eigen::Vector3d> SensorController::currentUnbiasedLoad()
 {
-    auto data = m_sensor_load_snapshot.load();
-    Eigen::Vector3d force(data.fx, data.fy, data.fz);
-    Eigen::Vector3d torque(data.tx, data.ty, data.tz);
+    auto data = m_latest_sample.load();
     std::shared_lock<std::shared_mutex> l(m_bias_lock);
-    return std::make_pair(force - m_force_bias, torque - m_torque_bias);
+    return std::make_pair(data.force() - m_force_bias, data.torque() - m_torque_bias);
+}
+
+void SensorController::setFilterPipeline(const FilterPipeline &pipeline)
+{
+    FilterPipeline filter = pipeline;
+    filter.reset();
+    std::lock_guard<std::mutex> l(m_listener_lock);
+    m_filter = std::move(filter);
+}
+
+void SensorController::setStatisticsWindows(std::span<const std::size_t> windows)
+{
+    std::lock_guard<std::mutex> l(m_listener_lock);
+    m_window_statistics.configure(windows);
+}
+
+WindowStatisticsSnapshot SensorController::windowStatistics(std::size_t window) const
+{
+    return m_window_statistics.snapshot(window);
+}
+
+SensorSample SensorController::latestSample() const
+{
+    return m_latest_sample.load();
+}
+
+SensorSample SensorController::latestFilteredSample() const
+{
+    return m_latest_filtered_sample.load();
+}
+
+std::optional<SensorSample> SensorController::waitForNext(uint64_t last_sequence, std::chrono::nanoseconds timeout)
+{
+    auto sample = m_latest_sample.load();
+    if(sample.sequence > last_sequence)
+        return sample;
+    std::unique_lock<std::mutex> l(m_wait_lock);
+    m_waiters++;
+    bool published = m_sample_published.wait_for(l, timeout, [&]()
+    {
+        sample = m_latest_sample.load();
+        return sample.sequence > last_sequence;
+    });
+    m_waiters--;
+    if(!published)
+        return std::nullopt;
+    return sample;
+}
+
+SensorController::SampleAwaiter SensorController::nextSample()
+{
+    return SampleAwaiter(*this, m_latest_sample.load().sequence);
+}
+
+SensorController::SampleAwaiter SensorController::nextSample(uint64_t last_sequence)
+{
+    return SampleAwaiter(*this, last_sequence);
+}
+
+#ifdef NETBOX_LINUX_SOCKET
+int SensorController::nativeHandle() const
+{
+    return m_netbox_rdt ? m_netbox_rdt->nativeHandle() : -1;
+}
+
+std::size_t SensorController::poll()
+{
+    return m_netbox_rdt ? m_netbox_rdt->poll() : 0u;
+}
+#endif
+
+SensorController::SampleAwaiter::SampleAwaiter(SensorController &controller, uint64_t last_sequence)
+: m_controller(controller)
+, m_last_sequence(last_sequence)
+, m_next(nullptr)
+{
+}
+
+bool SensorController::SampleAwaiter::await_ready()
+{
+    m_sample = m_controller.m_latest_sample.load();
+    return m_sample.sequence > m_last_sequence;
+}
+
+bool SensorController::SampleAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    auto &controller = m_controller;
+    auto last_sequence = m_last_sequence;
+    m_handle = handle;
+    m_next = controller.m_awaiters.load(std::memory_order_relaxed);
+    while(!controller.m_awaiters.compare_exchange_weak(m_next, this, std::memory_order_seq_cst, std::memory_order_relaxed))
+        ;
+    // From here on the publisher may resume us at any time, so only locals are touched. If a sample landed between
+    // await_ready() and the push, nobody may come to wake us: take the list and resume it ourselves.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(controller.m_latest_sample.load().sequence <= last_sequence)
+        return true;
+    auto awaiters = controller.m_awaiters.exchange(nullptr, std::memory_order_acq_rel);
+    bool own = false;
+    for(auto awaiter = awaiters; awaiter; awaiter = awaiter->m_next)
+        own |= awaiter == this;
+    controller.resumeAwaiters(awaiters, this);
+    return !own;
+}
+
+SensorSample SensorController::SampleAwaiter::await_resume() const
+{
+    return m_sample;
 }
 
 void SensorController::addSensorReadingReceivedListener(SensorController::SensorReadingListener listener)
@@ -75,35 +266,172 @@ void SensorController::addSensorReadingReceivedListener(SensorController::Sensor
     m_listeners.push_back(listener);
 }
 
-void SensorController::sensorLoadReceived(int32_t fx, int32_t fy, int32_t fz, int32_t tx, int32_t ty, int32_t tz)
-{
-    double cpf = m_count_per_force.load();
-    double cpt = m_count_per_torque.load();
-    Eigen::ArrayXd m(6);
-    m(0) = (double)fx / cpf;
-    m(1) = (double)fy / cpf;
-    m(2) = (double)fz / cpf;
-    m(3) = (double)tx / cpt;
-    m(4) = (double)ty / cpt;
-    m(5) = (double)tz / cpt;
-    Eigen::Vector3d f(m.head(3));
-    Eigen::Vector3d t(m.tail(3));
-    m_sensor_load_snapshot =
-    {
-        f.x(),
-        f.y(),
-        f.z(),
-        t.x(),
-        t.y(),
-        t.z()
-    };
+const SampleHistory &SensorController::sampleHistory() const
+{
+    return m_history;
+}
+
+std::size_t SensorController::readSamplesSince(uint64_t &sequence, std::span<SensorSample> samples) const
+{
+    return m_history.readSince(sequence, samples);
+}
+
+void SensorController::addSensorSampleListener(SensorController::SensorSampleListener listener)
+{
+    std::lock_guard<std::mutex> l(m_listener_lock);
+    m_sample_listeners.push_back(listener);
+}
+
+void SensorController::addFilteredSampleListener(SensorController::SensorSampleListener listener)
+{
+    std::lock_guard<std::mutex> l(m_listener_lock);
+    m_filtered_listeners.push_back(listener);
+}
+
+void SensorController::addRawBatchListener(SensorController::RawBatchListener listener)
+{
+    std::lock_guard<std::mutex> l(m_listener_lock);
+    m_raw_listeners.push_back(listener);
+}
+
+std::size_t SensorController::addAsyncSampleListener(SensorController::SensorSampleListener listener, const AsyncListenerOptions &options)
+{
+    std::lock_guard<std::mutex> l(m_listener_lock);
+    return m_dispatcher.subscribe(std::move(listener), options, RAW_STREAM);
+}
+
+std::size_t SensorController::addAsyncFilteredSampleListener(SensorController::SensorSampleListener listener, const AsyncListenerOptions &options)
+{
+    std::lock_guard<std::mutex> l(m_listener_lock);
+    return m_dispatcher.subscribe(std::move(listener), options, FILTERED_STREAM);
+}
+
+SubscriberStatistics SensorController::subscriberStatistics(std::size_t subscriber) const
+{
+    return m_dispatcher.statistics(subscriber);
+}
+
+void SensorController::ingest(std::span<const RTDResponse> batch, SampleTime received)
+{
+    if(!m_sensor_connected.load(std::memory_order_relaxed))
+        m_sensor_connected = true;
+    auto now = std::chrono::system_clock::now();
     {
         std::lock_guard<std::mutex> l(m_listener_lock);
-        if(m_listeners.empty())
-            return;
-        for(const auto &listener : m_listeners)
-            listener(f, t);
+        for(const auto &listener : m_raw_listeners)
+            listener(batch, received);
+        auto period = batch.empty() ? SampleTime::duration::zero() : samplePeriod(batch, received);
+        std::array<std::array<double, 6>, 64> loads;
+        for(std::size_t offset = 0; offset < batch.size(); offset += loads.size())
+        {
+            auto chunk = batch.subspan(offset, std::min(loads.size(), batch.size() - offset));
+            {
+                std::shared_lock<std::shared_mutex> c(m_calibration_lock);
+                m_calibration.convert(chunk, loads.data());
+            }
+            for(std::size_t i = 0; i < chunk.size(); i++)
+            {
+                // Records of several units sharing a sample index share a timestamp; anything further back than
+                // the datagram could hold is not a buffered record and keeps the receive time.
+                uint32_t behind = batch.back().ft_internal_sequence_index - chunk[i].ft_internal_sequence_index;
+                auto timestamp = behind < batch.size() ? received - behind * period : received;
+                sensorLoadReceived(timestamp, received, now, loads[i]);
+            }
+        }
     }
+    notifyWaiters();
+}
+
+void SensorController::setSampleRate(double rate)
+{
+    auto period = rate > 0.0 ? std::chrono::duration_cast<SampleTime::duration>(std::chrono::duration<double>(1.0 / rate))
+                             : SampleTime::duration::zero();
+    m_nominal_period.store(period.count(), std::memory_order_relaxed);
+}
+
+SampleTime::duration SensorController::samplePeriod(std::span<const RTDResponse> batch, SampleTime received)
+{
+    auto nominal = m_nominal_period.load(std::memory_order_relaxed);
+    if(nominal > 0)
+        return SampleTime::duration(nominal);
+    // Receive time per sample index between consecutive datagrams, smoothed over about 16 datagrams.
+    auto index = batch.back().ft_internal_sequence_index;
+    if(m_period_index)
+    {
+        uint32_t advance = index - *m_period_index;
+        auto elapsed = std::chrono::duration<double, SampleTime::period>(received - m_period_received).count();
+        if(advance > 0u && advance <= MAX_PERIOD_INDEX_ADVANCE && elapsed > 0.0)
+        {
+            auto period = elapsed / advance;
+            m_estimated_period = m_estimated_period > 0.0 ? m_estimated_period + (period - m_estimated_period) / 16.0 : period;
+        }
+    }
+    m_period_index = index;
+    m_period_received = received;
+    return SampleTime::duration(static_cast<SampleTime::rep>(m_estimated_period));
+}
+
+void SensorController::notifyWaiters()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(m_awaiters.load(std::memory_order_relaxed))
+        resumeAwaiters(m_awaiters.exchange(nullptr, std::memory_order_acq_rel));
+    if(m_waiters.load() == 0u)
+        return;
+    {
+        std::lock_guard<std::mutex> l(m_wait_lock);
+    }
+    m_sample_published.notify_all();
+}
+
+void SensorController::resumeAwaiters(SampleAwaiter *awaiters, SampleAwaiter *self)
+{
+    auto sample = m_latest_sample.load();
+    while(awaiters)
+    {
+        // Read the link before resuming: the awaiter lives in the coroutine frame, which may be gone afterwards.
+        auto awaiter = awaiters;
+        awaiters = awaiter->m_next;
+        if(sample.sequence <= awaiter->m_last_sequence)
+        {
+            awaiter->m_next = m_awaiters.load(std::memory_order_relaxed);
+            while(!m_awaiters.compare_exchange_weak(awaiter->m_next, awaiter, std::memory_order_seq_cst, std::memory_order_relaxed))
+                ;
+            continue;
+        }
+        awaiter->m_sample = sample;
+        if(awaiter != self)
+            awaiter->m_handle.resume();
+    }
+}
+
+void SensorController::sensorLoadReceived(SampleTime timestamp, SampleTime received, SampleTime dispatched,
+                                          const std::array<double, 6> &load)
+{
+    Eigen::Vector3d f(load[0], load[1], load[2]);
+    Eigen::Vector3d t(load[3], load[4], load[5]);
+    SensorSample sample;
+    sample.timestamp = timestamp;
+    sample.latency = dispatched - received;
+    sample.load = load;
+    sample.sequence = m_history.push(sample);
+    m_latest_sample.store(sample);
+    m_window_statistics.update(sample);
+    for(const auto &listener : m_listeners)
+        listener(f, t);
+    for(const auto &listener : m_sample_listeners)
+        listener(sample);
+    m_dispatcher.publish(sample, RAW_STREAM);
+    if(m_filter.empty())
+        return;
+    Channels channels = Eigen::Map<const Channels>(load.data());
+    if(!m_filter.process(channels))
+        return;
+    Eigen::Map<Channels>(sample.load.data()) = channels;
+    m_latest_filtered_sample.store(sample);
+    for(const auto &listener : m_filtered_listeners)
+        listener(sample);
+    m_dispatcher.publish(sample, FILTERED_STREAM);
 }
 
 void SensorController::startSensorInterface()
@@ -111,14 +439,12 @@ void SensorController::startSensorInterface()
     std::unique_lock<std::shared_mutex> l(m_interface_lock);
     if(m_netbox_rdt)
     {
+        m_statistics = nullptr;
         if(m_netbox_rdt->isStreaming())
             m_netbox_rdt->stopStreaming();
         m_netbox_rdt.reset();
     }
     m_netbox_rdt = std::make_unique<NetboxRdtClient>();
-    auto cb = std::bind(&SensorController::sensorLoadReceived, this, std::placeholders::_1, std::placeholders::_2,
-                        std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6);
-    m_netbox_rdt->setSensorLoadListener(cb);
-    m_netbox_rdt->startStreaming(m_hostname, m_port);
-    m_sensor_connected = true;
+    attach(*m_netbox_rdt);
+    m_netbox_rdt->startStreaming(m_hostname, m_port, m_settings);
 }
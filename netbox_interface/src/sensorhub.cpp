@@ -0,0 +1,164 @@
+#include "sensor_interface/sensorhub.h"
+
+#include <cerrno>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+using namespace estimation::sensor_interface;
+
+namespace {
+constexpr std::chrono::milliseconds WATCHDOG_INTERVAL{25};
+}
+
+SensorHub::SensorHub(std::size_t io_threads)
+: m_running(true)
+, m_io_threads(std::max<std::size_t>(io_threads, 1u))
+{
+    for(auto &io_thread : m_io_threads)
+    {
+        io_thread.epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+        io_thread.wake_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if(io_thread.epoll_fd < 0 || io_thread.wake_fd < 0)
+        {
+            stop();
+            throw std::runtime_error(std::string("Unable to create sensor hub event loop: ") + std::strerror(errno));
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;
+        ::epoll_ctl(io_thread.epoll_fd, EPOLL_CTL_ADD, io_thread.wake_fd, &event);
+    }
+    for(auto &io_thread : m_io_threads)
+        io_thread.thread = std::thread(&SensorHub::run, this, std::ref(io_thread));
+}
+
+SensorHub::~SensorHub()
+{
+    stop();
+}
+
+SensorController &SensorHub::addSensor(const std::string &hostname, uint16_t port, const NetboxStreamSettings &settings,
+                                       std::size_t history_capacity)
+{
+    std::lock_guard<std::mutex> l(m_sensor_lock);
+    return *openSensor(hostname, port, settings, history_capacity).controllers.front();
+}
+
+std::vector<SensorController*> SensorHub::addMultiUnitSensor(const std::string &hostname, uint16_t port, uint32_t unit_count,
+                                                             NetboxStreamSettings settings, std::size_t history_capacity)
+{
+    settings.command = RTDCommand::START_MULTI_UNIT_STREAMING;
+    settings.unit_count = std::max(unit_count, 1u);
+    std::lock_guard<std::mutex> l(m_sensor_lock);
+    auto &sensor = openSensor(hostname, port, settings, history_capacity);
+    std::vector<SensorController*> controllers;
+    for(const auto &controller : sensor.controllers)
+        controllers.push_back(controller.get());
+    return controllers;
+}
+
+SensorHub::Sensor &SensorHub::openSensor(const std::string &hostname, uint16_t port, const NetboxStreamSettings &settings,
+                                         std::size_t history_capacity)
+{
+    auto sensor = std::make_unique<Sensor>();
+    auto units = settings.command == RTDCommand::START_MULTI_UNIT_STREAMING ? std::max(settings.unit_count, 1u) : 1u;
+    for(uint32_t unit = 0; unit < units; unit++)
+    {
+        sensor->controllers.push_back(std::make_unique<SensorController>(history_capacity));
+        sensor->controllers.back()->attach(sensor->client, unit);
+    }
+    sensor->client.openStream(hostname, port, settings);
+
+    sensor->io_thread = m_sensors.size() % m_io_threads.size();
+    auto &io_thread = m_io_threads[sensor->io_thread];
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = sensor.get();
+    if(::epoll_ctl(io_thread.epoll_fd, EPOLL_CTL_ADD, sensor->client.nativeHandle(), &event) != 0)
+        throw std::runtime_error(std::string("Unable to register Netbox connection: ") + std::strerror(errno));
+    for(const auto &controller : sensor->controllers)
+        m_controllers.push_back(controller.get());
+    m_sensors.push_back(std::move(sensor));
+    return *m_sensors.back();
+}
+
+std::size_t SensorHub::sensorCount() const
+{
+    std::lock_guard<std::mutex> l(m_sensor_lock);
+    return m_controllers.size();
+}
+
+SensorController &SensorHub::sensor(std::size_t index)
+{
+    std::lock_guard<std::mutex> l(m_sensor_lock);
+    return *m_controllers.at(index);
+}
+
+void SensorHub::stop()
+{
+    if(!m_running.exchange(false))
+        return;
+    for(auto &io_thread : m_io_threads)
+    {
+        if(io_thread.wake_fd >= 0)
+        {
+            uint64_t one = 1u;
+            [[maybe_unused]] auto written = ::write(io_thread.wake_fd, &one, sizeof(one));
+        }
+        if(io_thread.thread.joinable())
+            io_thread.thread.join();
+    }
+    {
+        std::lock_guard<std::mutex> l(m_sensor_lock);
+        for(auto &sensor : m_sensors)
+            sensor->client.stopStreaming();
+    }
+    for(auto &io_thread : m_io_threads)
+    {
+        if(io_thread.epoll_fd >= 0)
+            ::close(io_thread.epoll_fd);
+        if(io_thread.wake_fd >= 0)
+            ::close(io_thread.wake_fd);
+        io_thread.epoll_fd = -1;
+        io_thread.wake_fd = -1;
+    }
+}
+
+void SensorHub::run(IoThread &io_thread)
+{
+    auto index = static_cast<std::size_t>(&io_thread - m_io_threads.data());
+    auto next_watchdog = std::chrono::steady_clock::now() + WATCHDOG_INTERVAL;
+    epoll_event events[64];
+    std::vector<Sensor*> watched;
+    while(m_running)
+    {
+        auto count = ::epoll_wait(io_thread.epoll_fd, events, 64, static_cast<int>(WATCHDOG_INTERVAL.count()));
+        for(int i = 0; i < count; i++)
+        {
+            auto sensor = static_cast<Sensor*>(events[i].data.ptr);
+            if(sensor)
+                sensor->client.poll();
+        }
+        auto now = std::chrono::steady_clock::now();
+        if(now < next_watchdog)
+            continue;
+        next_watchdog = now + WATCHDOG_INTERVAL;
+        // Connection listeners may call back into the hub, so the watchdogs run outside the sensor lock.
+        watched.clear();
+        {
+            std::lock_guard<std::mutex> l(m_sensor_lock);
+            for(auto &sensor : m_sensors)
+            {
+                if(sensor->io_thread == index)
+                    watched.push_back(sensor.get());
+            }
+        }
+        for(auto sensor : watched)
+            sensor->client.watchdog();
+    }
+}
@@ -0,0 +1,268 @@
+#include "sensor_interface/sharedsamplestream.h"
+#include "sensor_interface/sensorcontroller.h"
+
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <climits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+using namespace estimation::sensor_interface;
+
+namespace {
+static_assert(sizeof(SharedStreamHeader) <= SharedStreamHeader::SLOTS_OFFSET, "Header overlaps the sample slots");
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "Shared-memory atomics must be address free");
+static_assert(std::is_trivially_copyable_v<SensorSample>, "Samples are shared between processes as raw bytes");
+
+std::string segmentName(const std::string &name)
+{
+    return name.empty() || name.front() != '/' ? "/" + name : name;
+}
+
+std::size_t segmentSize(std::size_t capacity)
+{
+    return SharedStreamHeader::SLOTS_OFFSET + capacity * sizeof(SampleHistory::Slot);
+}
+
+SampleHistory::Slot *slots(SharedStreamHeader *header)
+{
+    return reinterpret_cast<SampleHistory::Slot*>(reinterpret_cast<unsigned char*>(header) + SharedStreamHeader::SLOTS_OFFSET);
+}
+
+// Pid of the live process publishing into an existing segment, or 0 if it is gone (or never finished setting the
+// segment up) and the name can be reclaimed.
+int64_t livePublisher(const std::string &name)
+{
+    int fd = ::shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if(fd < 0)
+        return 0;
+    struct stat status;
+    void *mapping = MAP_FAILED;
+    if(::fstat(fd, &status) == 0 && status.st_size >= static_cast<off_t>(SharedStreamHeader::SLOTS_OFFSET))
+        mapping = ::mmap(nullptr, SharedStreamHeader::SLOTS_OFFSET, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(mapping == MAP_FAILED)
+        return 0;
+    auto header = static_cast<const SharedStreamHeader*>(mapping);
+    int64_t pid = header->magic.load(std::memory_order_acquire) == SharedStreamHeader::MAGIC ? header->publisher_pid : 0;
+    ::munmap(mapping, SharedStreamHeader::SLOTS_OFFSET);
+    if(pid <= 0 || (::kill(static_cast<pid_t>(pid), 0) != 0 && errno != EPERM))
+        return 0;
+    return pid;
+}
+
+// Shared (not FUTEX_PRIVATE) futex operations, so waiters in other processes are woken.
+void futexWake(std::atomic<uint32_t> &word)
+{
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+void futexWait(std::atomic<uint32_t> &word, uint32_t expected, std::chrono::nanoseconds timeout)
+{
+    timespec relative{static_cast<time_t>(timeout.count() / 1000000000), static_cast<long>(timeout.count() % 1000000000)};
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, &relative, nullptr, 0);
+}
+}
+
+struct SharedSamplePublisher::Segment
+{
+    std::size_t size;
+    SharedStreamHeader *header;
+    std::unique_ptr<SampleHistory> history;
+
+    Segment(SharedStreamHeader *header, std::size_t size)
+    : size(size)
+    , header(header)
+    , history(std::make_unique<SampleHistory>(slots(header), header->capacity, &header->head))
+    {
+    }
+
+    ~Segment()
+    {
+        ::munmap(header, size);
+    }
+
+    void publish(const SensorSample &sample)
+    {
+        history->push(sample);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(header->waiters.load(std::memory_order_relaxed) == 0u)
+            return;
+        header->published.fetch_add(1u, std::memory_order_release);
+        futexWake(header->published);
+    }
+
+    void setConnected(bool connected)
+    {
+        header->connected.store(connected, std::memory_order_release);
+        header->published.fetch_add(1u, std::memory_order_release);
+        futexWake(header->published);
+    }
+};
+
+SharedSamplePublisher::SharedSamplePublisher(const std::string &name, SensorController &controller, std::size_t capacity, bool filtered)
+: m_name(segmentName(name))
+{
+    capacity = std::bit_ceil(std::max<std::size_t>(capacity, 2u));
+    auto size = segmentSize(capacity);
+    int fd = ::shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0660);
+    if(fd < 0 && errno == EEXIST)
+    {
+        // Only a segment left behind by a publisher that died without unlinking it is taken over; a live one keeps
+        // its name and subscribers.
+        if(auto pid = livePublisher(m_name))
+            throw std::runtime_error("Shared memory " + m_name + " is in use by publisher process " + std::to_string(pid));
+        ::shm_unlink(m_name.c_str());
+        fd = ::shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0660);
+    }
+    if(fd < 0)
+        throw std::runtime_error("Unable to create shared memory " + m_name + ": " + std::strerror(errno));
+    void *mapping = MAP_FAILED;
+    if(::ftruncate(fd, static_cast<off_t>(size)) == 0)
+        mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    auto error = errno;
+    ::close(fd);
+    if(mapping == MAP_FAILED)
+    {
+        ::shm_unlink(m_name.c_str());
+        throw std::runtime_error("Unable to map shared memory " + m_name + ": " + std::strerror(error));
+    }
+
+    // ftruncate() zero-fills the segment, which is the initial state of every slot.
+    auto header = new(mapping) SharedStreamHeader{};
+    header->version = SharedStreamHeader::VERSION;
+    header->slot_size = sizeof(SampleHistory::Slot);
+    header->capacity = capacity;
+    header->publisher_pid = ::getpid();
+    header->head = 1u;
+    header->connected = controller.hasConnectedSensor();
+    m_segment = std::make_shared<Segment>(header, size);
+    header->magic.store(SharedStreamHeader::MAGIC, std::memory_order_release);
+
+    controller.addConnectionListener([segment = m_segment](bool connected)
+    {
+        segment->setConnected(connected);
+    });
+    auto listener = [segment = m_segment](const SensorSample &sample)
+    {
+        segment->publish(sample);
+    };
+    if(filtered)
+        controller.addFilteredSampleListener(listener);
+    else
+        controller.addSensorSampleListener(listener);
+}
+
+SharedSamplePublisher::~SharedSamplePublisher()
+{
+    m_segment->setConnected(false);
+    ::shm_unlink(m_name.c_str());
+}
+
+const std::string &SharedSamplePublisher::name() const
+{
+    return m_name;
+}
+
+SharedSampleSubscriber::SharedSampleSubscriber(const std::string &name)
+: m_size(0u)
+, m_header(nullptr)
+{
+    auto segment = segmentName(name);
+    int fd = ::shm_open(segment.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if(fd < 0)
+        throw std::runtime_error("Unable to open shared memory " + segment + ": " + std::strerror(errno));
+    struct stat status;
+    void *mapping = MAP_FAILED;
+    if(::fstat(fd, &status) == 0 && status.st_size >= static_cast<off_t>(SharedStreamHeader::SLOTS_OFFSET))
+    {
+        m_size = static_cast<std::size_t>(status.st_size);
+        mapping = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if(mapping == MAP_FAILED)
+        throw std::runtime_error("Unable to map shared memory " + segment);
+
+    m_header = static_cast<SharedStreamHeader*>(mapping);
+    if(m_header->magic.load(std::memory_order_acquire) != SharedStreamHeader::MAGIC ||
+       m_header->version != SharedStreamHeader::VERSION || m_header->slot_size != sizeof(SampleHistory::Slot) ||
+       !std::has_single_bit(m_header->capacity) || segmentSize(m_header->capacity) > m_size)
+    {
+        ::munmap(mapping, m_size);
+        throw std::runtime_error(segment + " is not a compatible Netbox sample stream");
+    }
+    m_history = std::make_unique<SampleHistory>(slots(m_header), m_header->capacity, &m_header->head);
+}
+
+SharedSampleSubscriber::~SharedSampleSubscriber()
+{
+    ::munmap(m_header, m_size);
+}
+
+bool SharedSampleSubscriber::hasConnectedSensor() const
+{
+    return m_header->connected.load(std::memory_order_acquire) != 0u;
+}
+
+std::pair<Eigen::Vector3d, Eigen::Vector3d> SharedSampleSubscriber::currentRawLoad() const
+{
+    auto sample = latestSample();
+    return std::make_pair(sample.force(), sample.torque());
+}
+
+SensorSample SharedSampleSubscriber::latestSample() const
+{
+    SensorSample sample;
+    while(true)
+    {
+        uint64_t cursor = m_history->nextSequence();
+        if(cursor <= 1u)
+            return {};
+        cursor--;
+        if(m_history->readSince(cursor, std::span<SensorSample>(&sample, 1u)) == 1u)
+            return sample;
+    }
+}
+
+std::optional<SensorSample> SharedSampleSubscriber::waitForNext(uint64_t last_sequence, std::chrono::nanoseconds timeout)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    m_header->waiters.fetch_add(1u, std::memory_order_seq_cst);
+    std::optional<SensorSample> result;
+    while(true)
+    {
+        auto published = m_header->published.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto sample = latestSample();
+        if(sample.sequence > last_sequence)
+        {
+            result = sample;
+            break;
+        }
+        auto remaining = deadline - std::chrono::steady_clock::now();
+        if(remaining <= std::chrono::nanoseconds::zero())
+            break;
+        futexWait(m_header->published, published, std::chrono::duration_cast<std::chrono::nanoseconds>(remaining));
+    }
+    m_header->waiters.fetch_sub(1u, std::memory_order_relaxed);
+    return result;
+}
+
+const SampleHistory &SharedSampleSubscriber::sampleHistory() const
+{
+    return *m_history;
+}
+
+std::size_t SharedSampleSubscriber::readSamplesSince(uint64_t &sequence, std::span<SensorSample> samples) const
+{
+    return m_history->readSince(sequence, samples);
+}
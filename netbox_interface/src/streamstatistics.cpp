@@ -0,0 +1,174 @@
+#include "sensor_interface/streamstatistics.h"
+#include "sensor_interface/netboxrdtclient.h"
+
+#include <bit>
+#include <cmath>
+
+using namespace estimation::sensor_interface;
+
+namespace {
+constexpr std::chrono::milliseconds RATE_WINDOW{500};
+
+void bump(std::atomic<uint64_t> &counter, uint64_t amount = 1u)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+}
+
+StreamStatistics::StreamStatistics()
+{
+    reset();
+}
+
+void StreamStatistics::reset()
+{
+    m_datagrams = 0u;
+    m_records = 0u;
+    m_dropped = 0u;
+    m_duplicated = 0u;
+    m_reordered = 0u;
+    m_sensor_skipped = 0u;
+    m_status_flagged = 0u;
+    m_last_status = 0u;
+    m_sample_rate = 0.0;
+    m_jitter = 0.0;
+    for(auto &bucket : m_histogram)
+        bucket = 0u;
+    m_max_wakeup_latency = 0;
+    for(auto &bucket : m_wakeup_histogram)
+        bucket = 0u;
+    m_started = false;
+    m_highest_sequence = 0u;
+    m_sequence_window = 0u;
+    m_last_ft_sequence = 0u;
+    m_last_arrival = SampleTime();
+    m_rate_window_start = SampleTime();
+    m_rate_window_records = 0u;
+    m_mean_interval = 0.0;
+}
+
+void StreamStatistics::resynchronize()
+{
+    m_started = false;
+    m_sequence_window = 0u;
+    m_last_arrival = SampleTime();
+    m_rate_window_start = SampleTime();
+    m_rate_window_records = 0u;
+}
+
+void StreamStatistics::update(std::span<const RTDResponse> batch, SampleTime arrival)
+{
+    if(batch.empty())
+        return;
+    for(const auto &response : batch)
+        trackSequence(response);
+    bump(m_records, batch.size());
+    m_last_status.store(batch.back().status, std::memory_order_relaxed);
+    trackArrival(arrival, batch.size());
+}
+
+void StreamStatistics::recordWakeup(std::chrono::nanoseconds latency)
+{
+    auto nanos = std::max<int64_t>(latency.count(), 0);
+    if(nanos > m_max_wakeup_latency.load(std::memory_order_relaxed))
+        m_max_wakeup_latency.store(nanos, std::memory_order_relaxed);
+    auto bucket = std::min<std::size_t>(std::bit_width(static_cast<uint64_t>(nanos / 1000)), m_wakeup_histogram.size() - 1u);
+    bump(m_wakeup_histogram[bucket]);
+}
+
+void StreamStatistics::trackSequence(const RTDResponse &response)
+{
+    if(response.status != 0u)
+        bump(m_status_flagged);
+    if(!m_started)
+    {
+        m_started = true;
+        m_highest_sequence = response.rdt_package_sequence_index;
+        m_sequence_window = 1u;
+        m_last_ft_sequence = response.ft_internal_sequence_index;
+        return;
+    }
+
+    // Signed distance handles wrap-around of the 32-bit sequence counters.
+    auto ahead = static_cast<int32_t>(response.rdt_package_sequence_index - m_highest_sequence);
+    if(ahead > 0)
+    {
+        if(ahead > 1)
+            bump(m_dropped, ahead - 1);
+        m_sequence_window = ahead >= 64 ? 1u : (m_sequence_window << ahead) | 1u;
+        m_highest_sequence = response.rdt_package_sequence_index;
+
+        auto ft_step = static_cast<int32_t>(response.ft_internal_sequence_index - m_last_ft_sequence);
+        if(ft_step > ahead)
+            bump(m_sensor_skipped, ft_step - ahead);
+        m_last_ft_sequence = response.ft_internal_sequence_index;
+        return;
+    }
+
+    auto behind = static_cast<uint32_t>(-ahead);
+    if(behind < 64u && (m_sequence_window & (uint64_t(1) << behind)))
+    {
+        bump(m_duplicated);
+        return;
+    }
+    bump(m_reordered);
+    if(behind < 64u)
+    {
+        m_sequence_window |= uint64_t(1) << behind;
+        auto dropped = m_dropped.load(std::memory_order_relaxed);
+        if(dropped > 0u)
+            m_dropped.store(dropped - 1u, std::memory_order_relaxed);
+    }
+}
+
+void StreamStatistics::trackArrival(SampleTime arrival, std::size_t records)
+{
+    bump(m_datagrams);
+    if(m_rate_window_start == SampleTime())
+        m_rate_window_start = arrival;
+    m_rate_window_records += records;
+    auto window = arrival - m_rate_window_start;
+    if(window >= RATE_WINDOW)
+    {
+        m_sample_rate.store(m_rate_window_records / std::chrono::duration<double>(window).count(), std::memory_order_relaxed);
+        m_rate_window_start = arrival;
+        m_rate_window_records = 0u;
+    }
+
+    if(m_last_arrival != SampleTime())
+    {
+        auto interval = std::chrono::duration<double>(arrival - m_last_arrival).count();
+        auto micros = static_cast<uint64_t>(std::max(interval, 0.0) * 1e6);
+        auto bucket = std::min<std::size_t>(std::bit_width(micros), m_histogram.size() - 1u);
+        bump(m_histogram[bucket]);
+
+        // RFC 3550 style smoothing of the deviation from the mean datagram spacing.
+        if(m_mean_interval == 0.0)
+            m_mean_interval = interval;
+        m_mean_interval += (interval - m_mean_interval) / 16.0;
+        auto jitter = m_jitter.load(std::memory_order_relaxed);
+        m_jitter.store(jitter + (std::abs(interval - m_mean_interval) - jitter) / 16.0, std::memory_order_relaxed);
+    }
+    m_last_arrival = arrival;
+}
+
+StreamStatisticsSnapshot StreamStatistics::snapshot() const
+{
+    StreamStatisticsSnapshot snapshot;
+    snapshot.datagrams = m_datagrams.load(std::memory_order_relaxed);
+    snapshot.records = m_records.load(std::memory_order_relaxed);
+    snapshot.dropped = m_dropped.load(std::memory_order_relaxed);
+    snapshot.duplicated = m_duplicated.load(std::memory_order_relaxed);
+    snapshot.reordered = m_reordered.load(std::memory_order_relaxed);
+    snapshot.sensor_skipped = m_sensor_skipped.load(std::memory_order_relaxed);
+    snapshot.status_flagged = m_status_flagged.load(std::memory_order_relaxed);
+    snapshot.last_status = m_last_status.load(std::memory_order_relaxed);
+    snapshot.sample_rate = m_sample_rate.load(std::memory_order_relaxed);
+    snapshot.jitter = m_jitter.load(std::memory_order_relaxed);
+    for(std::size_t i = 0; i < m_histogram.size(); i++)
+        snapshot.interarrival_histogram[i] = m_histogram[i].load(std::memory_order_relaxed);
+    snapshot.max_wakeup_latency = std::chrono::nanoseconds(m_max_wakeup_latency.load(std::memory_order_relaxed));
+    for(std::size_t i = 0; i < m_wakeup_histogram.size(); i++)
+        snapshot.wakeup_latency_histogram[i] = m_wakeup_histogram[i].load(std::memory_order_relaxed);
+    return snapshot;
+}
@@ -0,0 +1,156 @@
+#include "sensor_interface/windowstatistics.h"
+
+#include <bit>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+
+using namespace estimation::sensor_interface;
+
+WindowStatistics::WindowStatistics()
+: m_sample_mask(0u)
+, m_index(0u)
+, m_window_count(0u)
+{
+}
+
+void WindowStatistics::configure(std::span<const std::size_t> windows)
+{
+    m_windows.clear();
+    std::size_t longest = 1u;
+    for(auto length : windows.first(std::min(windows.size(), MAX_WINDOWS)))
+    {
+        Window window;
+        window.length = std::max<std::size_t>(length, 1u);
+        auto capacity = std::bit_ceil(window.length + 1u);
+        for(std::size_t channel = 0; channel < 6u; channel++)
+        {
+            window.min[channel].indices.resize(capacity);
+            window.max[channel].indices.resize(capacity);
+        }
+        longest = std::max(longest, window.length);
+        m_windows.push_back(std::move(window));
+    }
+    // One shared ring holds the longest window; shorter windows look back into it for the sample they drop.
+    m_samples.assign(std::bit_ceil(longest + 1u), {});
+    m_sample_mask = m_samples.size() - 1u;
+    reset();
+    m_window_count.store(m_windows.size(), std::memory_order_release);
+}
+
+void WindowStatistics::reset()
+{
+    m_index = 0u;
+    for(std::size_t w = 0; w < m_windows.size(); w++)
+    {
+        auto &window = m_windows[w];
+        window.count = 0u;
+        window.slides = 0u;
+        window.mean.setZero();
+        window.m2.setZero();
+        for(std::size_t channel = 0; channel < 6u; channel++)
+        {
+            window.min[channel].head = window.min[channel].tail = 0u;
+            window.max[channel].head = window.max[channel].tail = 0u;
+        }
+        WindowStatisticsSnapshot snapshot;
+        snapshot.window = window.length;
+        m_published[w].store(snapshot);
+    }
+}
+
+std::size_t WindowStatistics::windowCount() const
+{
+    return m_window_count.load(std::memory_order_acquire);
+}
+
+WindowStatisticsSnapshot WindowStatistics::snapshot(std::size_t window) const
+{
+    if(window >= MAX_WINDOWS)
+        return {};
+    return m_published[window].load();
+}
+
+template<typename Compare>
+void WindowStatistics::push(MonotonicDeque &deque, std::size_t channel, double value, Compare compare)
+{
+    auto mask = deque.indices.size() - 1u;
+    while(deque.tail != deque.head && !compare(m_samples[deque.indices[(deque.tail - 1u) & mask] & m_sample_mask][channel], value))
+        deque.tail--;
+    deque.indices[deque.tail++ & mask] = m_index;
+}
+
+double WindowStatistics::front(const MonotonicDeque &deque, std::size_t channel) const
+{
+    return m_samples[deque.indices[deque.head & (deque.indices.size() - 1u)] & m_sample_mask][channel];
+}
+
+// Two-pass mean and m2 over the full window ending at m_index, which the sliding updates drift away from over time.
+void WindowStatistics::recompute(Window &window) const
+{
+    window.slides = 0u;
+    auto first = m_index + 1u - window.length;
+    Eigen::Array<double, 6, 1> sum = Eigen::Array<double, 6, 1>::Zero();
+    for(auto index = first; index <= m_index; index++)
+        sum += Eigen::Map<const Eigen::Array<double, 6, 1>>(m_samples[index & m_sample_mask].data());
+    window.mean = sum / static_cast<double>(window.length);
+    window.m2.setZero();
+    for(auto index = first; index <= m_index; index++)
+        window.m2 += (Eigen::Map<const Eigen::Array<double, 6, 1>>(m_samples[index & m_sample_mask].data()) - window.mean).square();
+}
+
+void WindowStatistics::update(const SensorSample &sample)
+{
+    if(m_windows.empty())
+        return;
+    m_samples[m_index & m_sample_mask] = sample.load;
+    Eigen::Array<double, 6, 1> x = Eigen::Map<const Eigen::Array<double, 6, 1>>(sample.load.data());
+
+    for(std::size_t w = 0; w < m_windows.size(); w++)
+    {
+        auto &window = m_windows[w];
+        if(window.count < window.length)
+        {
+            window.count++;
+            Eigen::Array<double, 6, 1> delta = x - window.mean;
+            window.mean += delta / static_cast<double>(window.count);
+            window.m2 += delta * (x - window.mean);
+        }
+        else
+        {
+            // Replace the sample leaving the window in one step; the count stays at length.
+            Eigen::Array<double, 6, 1> y = Eigen::Map<const Eigen::Array<double, 6, 1>>(m_samples[(m_index - window.length) & m_sample_mask].data());
+            Eigen::Array<double, 6, 1> old_mean = window.mean;
+            window.mean += (x - y) / static_cast<double>(window.length);
+            window.m2 += (x - y) * (x - window.mean + y - old_mean);
+            window.m2 = window.m2.max(0.0);
+            if(++window.slides == window.length)
+                recompute(window);
+        }
+
+        WindowStatisticsSnapshot snapshot;
+        snapshot.window = window.length;
+        snapshot.count = window.count;
+        snapshot.sequence = sample.sequence;
+        auto oldest = m_index + 1u - window.count;
+        auto n = static_cast<double>(window.count);
+        for(std::size_t channel = 0; channel < 6u; channel++)
+        {
+            auto &min = window.min[channel];
+            auto &max = window.max[channel];
+            push(min, channel, sample.load[channel], std::less<double>());
+            push(max, channel, sample.load[channel], std::greater<double>());
+            while(min.indices[min.head & (min.indices.size() - 1u)] < oldest)
+                min.head++;
+            while(max.indices[max.head & (max.indices.size() - 1u)] < oldest)
+                max.head++;
+            snapshot.mean[channel] = window.mean[channel];
+            snapshot.variance[channel] = window.count > 1u ? window.m2[channel] / (n - 1.0) : 0.0;
+            snapshot.rms[channel] = std::sqrt(window.mean[channel] * window.mean[channel] + window.m2[channel] / n);
+            snapshot.min[channel] = front(min, channel);
+            snapshot.max[channel] = front(max, channel);
+        }
+        m_published[w].store(snapshot);
+    }
+    m_index++;
+}
@@ -0,0 +1,169 @@
+#include "virtualnetbox.h"
+
+#include <poll.h>
+#include <signal.h>
+#include <arpa/inet.h>
+
+#include <atomic>
+#include <memory>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+using namespace estimation::netbox_sim;
+
+namespace {
+std::atomic<bool> running{true};
+
+void usage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --address <ip>        first loopback address to serve (default 127.0.0.2)\n"
+              << "  --port <port>         RDT port (default 49152)\n"
+              << "  --netboxes <n>        virtual Netboxes on consecutive addresses (default 1)\n"
+              << "  --rate <hz>           sample rate per Netbox (default 7000)\n"
+              << "  --records <n>         records per datagram in buffered mode (default 10)\n"
+              << "  --units <n>           transducers per Netbox in multi-unit mode (default 1)\n"
+              << "  --loss <p>            probability of dropping a datagram\n"
+              << "  --reorder <p>         probability of delaying a datagram behind the next one\n"
+              << "  --duplicate <p>       probability of sending a datagram twice\n"
+              << "  --replay <file>       replay whitespace or comma separated Fx Fy Fz Tx Ty Tz counts\n"
+              << "  --counts <n>          counts per N and Nm for generated data (default 1000000)\n";
+}
+
+std::vector<std::array<int32_t, 6>> loadReplay(const std::string &path)
+{
+    std::ifstream file(path);
+    if(!file)
+        throw std::runtime_error("Unable to open replay file " + path);
+    std::vector<std::array<int32_t, 6>> samples;
+    std::string line;
+    while(std::getline(file, line))
+    {
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream stream(line);
+        std::array<int32_t, 6> sample;
+        if(stream >> sample[0] >> sample[1] >> sample[2] >> sample[3] >> sample[4] >> sample[5])
+            samples.push_back(sample);
+    }
+    if(samples.empty())
+        throw std::runtime_error("Replay file " + path + " holds no samples");
+    return samples;
+}
+
+std::string offsetAddress(const std::string &address, uint32_t offset)
+{
+    in_addr base{};
+    if(::inet_pton(AF_INET, address.c_str(), &base) != 1)
+        throw std::runtime_error("Invalid address " + address);
+    base.s_addr = htonl(ntohl(base.s_addr) + offset);
+    char text[INET_ADDRSTRLEN];
+    ::inet_ntop(AF_INET, &base, text, sizeof(text));
+    return text;
+}
+}
+
+int main(int argc, char **argv)
+{
+    std::string address = "127.0.0.2";
+    uint16_t port = 49152u;
+    uint32_t netbox_count = 1u;
+    SimulationSettings settings;
+    try
+    {
+        for(int i = 1; i < argc; i++)
+        {
+            std::string option = argv[i];
+            if(option == "--help" || option == "-h")
+            {
+                usage(argv[0]);
+                return 0;
+            }
+            if(i + 1 >= argc)
+                throw std::runtime_error("Missing value for " + option);
+            std::string value = argv[++i];
+            if(option == "--address")
+                address = value;
+            else if(option == "--port")
+                port = static_cast<uint16_t>(std::stoul(value));
+            else if(option == "--netboxes")
+                netbox_count = std::max(1ul, std::stoul(value));
+            else if(option == "--rate")
+                settings.rate = std::max(1.0, std::stod(value));
+            else if(option == "--records")
+                settings.records_per_packet = std::clamp<uint32_t>(std::stoul(value), 1u, 56u);
+            else if(option == "--units")
+                settings.unit_count = std::clamp<uint32_t>(std::stoul(value), 1u, 56u);
+            else if(option == "--loss")
+                settings.loss = std::stod(value);
+            else if(option == "--reorder")
+                settings.reorder = std::stod(value);
+            else if(option == "--duplicate")
+                settings.duplicate = std::stod(value);
+            else if(option == "--replay")
+                settings.replay = loadReplay(value);
+            else if(option == "--counts")
+                settings.counts_per_unit = std::stoul(value);
+            else
+                throw std::runtime_error("Unknown option " + option);
+        }
+    }
+    catch(const std::exception &e)
+    {
+        std::cerr << e.what() << "\n";
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<VirtualNetbox>> netboxes;
+    std::vector<pollfd> descriptors;
+    for(uint32_t i = 0; i < netbox_count; i++)
+    {
+        netboxes.push_back(std::make_unique<VirtualNetbox>(offsetAddress(address, i), port, settings, i + 1u));
+        descriptors.push_back({netboxes.back()->nativeHandle(), POLLIN, 0});
+        std::cerr << "Simulated Netbox listening on " << netboxes.back()->address() << ":" << port << "\n";
+    }
+
+    ::signal(SIGINT, [](int) { running = false; });
+    ::signal(SIGTERM, [](int) { running = false; });
+
+    auto report_time = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    uint64_t reported_records = 0u;
+    while(running)
+    {
+        auto now = std::chrono::steady_clock::now();
+        auto wake = now + std::chrono::milliseconds(100);
+        for(const auto &netbox : netboxes)
+        {
+            if(netbox->isStreaming())
+                wake = std::min(wake, netbox->nextSampleTime());
+        }
+        auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(std::max(wake - now, std::chrono::steady_clock::duration::zero()));
+        timespec timeout{static_cast<time_t>(wait.count() / 1000000000), static_cast<long>(wait.count() % 1000000000)};
+        if(::ppoll(descriptors.data(), descriptors.size(), &timeout, nullptr) > 0)
+        {
+            for(std::size_t i = 0; i < descriptors.size(); i++)
+            {
+                if(descriptors[i].revents & POLLIN)
+                    netboxes[i]->handleRequests();
+            }
+        }
+        now = std::chrono::steady_clock::now();
+        for(const auto &netbox : netboxes)
+            netbox->emitDueSamples(now);
+
+        if(now >= report_time)
+        {
+            uint64_t records = 0u;
+            for(const auto &netbox : netboxes)
+                records += netbox->sentRecords();
+            std::fprintf(stderr, "%llu records/s\n", static_cast<unsigned long long>(records - reported_records));
+            reported_records = records;
+            report_time += std::chrono::seconds(1);
+        }
+    }
+    return 0;
+}
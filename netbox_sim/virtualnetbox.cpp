@@ -0,0 +1,230 @@
+#include "virtualnetbox.h"
+
+#include <cmath>
+#include <cerrno>
+#include <cstring>
+#include <numbers>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+using namespace estimation::netbox_sim;
+using estimation::sensor_interface::RdtCodec;
+using estimation::sensor_interface::RTDCommand;
+using estimation::sensor_interface::RTDResponse;
+
+VirtualNetbox::VirtualNetbox(const std::string &address, uint16_t port, const SimulationSettings &settings, uint32_t seed)
+: m_fd(-1)
+, m_address(address)
+, m_settings(settings)
+, m_random(seed)
+, m_noise(0.0, 1.0)
+, m_chance(0.0, 1.0)
+, m_peer{}
+, m_streaming(false)
+, m_command(RTDCommand::STOP_STREAM)
+, m_samples_left(0u)
+, m_sample_index(0u)
+, m_bias{}
+, m_status(0u)
+, m_sent_datagrams(0u)
+, m_sent_records(0u)
+{
+    m_fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, IPPROTO_UDP);
+    if(m_fd < 0)
+        throw std::runtime_error(std::string("Unable to create simulator socket: ") + std::strerror(errno));
+    // Clients bind the same port on the wildcard address.
+    int reuse = 1;
+    ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    int buffer_size = 1 << 22;
+    ::setsockopt(m_fd, SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(port);
+    if(::inet_pton(AF_INET, address.c_str(), &local.sin_addr) != 1 ||
+       ::bind(m_fd, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0)
+    {
+        ::close(m_fd);
+        throw std::runtime_error("Unable to bind simulated Netbox to " + address + ":" + std::to_string(port) + ": " + std::strerror(errno));
+    }
+    m_packet.reserve(sensor_interface::RTD_MAX_DATAGRAM_SIZE);
+}
+
+VirtualNetbox::~VirtualNetbox()
+{
+    ::close(m_fd);
+}
+
+int VirtualNetbox::nativeHandle() const
+{
+    return m_fd;
+}
+
+const std::string &VirtualNetbox::address() const
+{
+    return m_address;
+}
+
+void VirtualNetbox::handleRequests()
+{
+    unsigned char buffer[64];
+    while(true)
+    {
+        sockaddr_in peer{};
+        socklen_t peer_length = sizeof(peer);
+        auto read = ::recvfrom(m_fd, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr*>(&peer), &peer_length);
+        if(read < 0)
+            return;
+        auto request = RdtCodec::decodeRequest(std::span<const unsigned char>(buffer, static_cast<std::size_t>(read)));
+        if(!request)
+            continue;
+        auto command = static_cast<RTDCommand>(request->command);
+        switch(command)
+        {
+        case RTDCommand::STOP_STREAM:
+            m_streaming = false;
+            break;
+        case RTDCommand::START_HIGH_SPEED_REALTIME_STREAM:
+        case RTDCommand::START_HIGH_SPEED_BUFFERED_STREAM:
+        case RTDCommand::START_MULTI_UNIT_STREAMING:
+            start(command, request->sample_count, peer);
+            break;
+        case RTDCommand::SET_SOFTWARE_BIAS:
+            m_bias = {};
+            m_bias = sampleCounts(0u);
+            break;
+        case RTDCommand::RESET_THRESHOLD_LATCH:
+            m_status = 0u;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+bool VirtualNetbox::isStreaming() const
+{
+    return m_streaming;
+}
+
+std::chrono::steady_clock::time_point VirtualNetbox::nextSampleTime() const
+{
+    return m_next_sample;
+}
+
+void VirtualNetbox::emitDueSamples(std::chrono::steady_clock::time_point now)
+{
+    auto samples_per_datagram = m_command == RTDCommand::START_HIGH_SPEED_BUFFERED_STREAM ? std::max(m_settings.records_per_packet, 1u) : 1u;
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(samples_per_datagram / m_settings.rate));
+    // Do not try to catch up on more than 100 ms after a scheduling stall; a real Netbox would have overrun too.
+    if(now - m_next_sample > std::chrono::milliseconds(100))
+        m_next_sample = now;
+    while(m_streaming && m_next_sample <= now)
+    {
+        m_packet.clear();
+        for(uint32_t i = 0; i < samples_per_datagram && m_streaming; i++)
+        {
+            auto units = m_command == RTDCommand::START_MULTI_UNIT_STREAMING ? m_settings.unit_count : 1u;
+            for(uint32_t unit = 0; unit < units; unit++)
+                appendRecord(unit, sampleCounts(unit));
+            m_sample_index++;
+            if(m_samples_left > 0u && --m_samples_left == 0u)
+                m_streaming = false;
+        }
+        transmit();
+        m_next_sample += period;
+    }
+}
+
+uint64_t VirtualNetbox::sentDatagrams() const
+{
+    return m_sent_datagrams;
+}
+
+uint64_t VirtualNetbox::sentRecords() const
+{
+    return m_sent_records;
+}
+
+void VirtualNetbox::start(RTDCommand command, uint32_t sample_count, const sockaddr_in &peer)
+{
+    m_peer = peer;
+    m_command = command;
+    m_streaming = true;
+    m_samples_left = sample_count;
+    m_rdt_sequence.assign(std::max(m_settings.unit_count, 1u), 0u);
+    m_held_packet.reset();
+    m_next_sample = std::chrono::steady_clock::now();
+}
+
+std::array<int32_t, 6> VirtualNetbox::sampleCounts(uint32_t unit)
+{
+    std::array<int32_t, 6> counts;
+    if(!m_settings.replay.empty())
+    {
+        counts = m_settings.replay[(m_sample_index + unit) % m_settings.replay.size()];
+    }
+    else
+    {
+        // Slow manipulation loads, a 50 Hz structural vibration and white sensor noise.
+        constexpr double amplitude[6] = {5.0, 3.0, 2.0, 0.3, 0.2, 0.1};
+        constexpr double frequency[6] = {0.5, 1.3, 0.2, 0.7, 0.9, 0.4};
+        constexpr double offset[6] = {0.0, 0.0, -20.0, 0.0, 0.0, 0.0};
+        auto t = m_sample_index / m_settings.rate;
+        for(std::size_t axis = 0; axis < counts.size(); axis++)
+        {
+            auto phase = 2.0 * std::numbers::pi * (frequency[axis] * t + 0.25 * unit);
+            auto value = offset[axis] + amplitude[axis] * std::sin(phase);
+            value += 0.02 * amplitude[axis] * std::sin(2.0 * std::numbers::pi * 50.0 * t);
+            value += 0.005 * amplitude[axis] * m_noise(m_random);
+            counts[axis] = static_cast<int32_t>(value * m_settings.counts_per_unit);
+        }
+    }
+    for(std::size_t axis = 0; axis < counts.size(); axis++)
+        counts[axis] -= m_bias[axis];
+    return counts;
+}
+
+void VirtualNetbox::appendRecord(uint32_t unit, const std::array<int32_t, 6> &counts)
+{
+    RTDResponse response
+    {
+        m_rdt_sequence[unit]++,
+        static_cast<uint32_t>(m_sample_index),
+        m_status,
+        counts[0], counts[1], counts[2],
+        counts[3], counts[4], counts[5]
+    };
+    auto record = RdtCodec::encode(response);
+    m_packet.insert(m_packet.end(), record.begin(), record.end());
+}
+
+void VirtualNetbox::send(const std::vector<unsigned char> &packet)
+{
+    auto sent = ::sendto(m_fd, packet.data(), packet.size(), 0, reinterpret_cast<const sockaddr*>(&m_peer), sizeof(m_peer));
+    if(sent < 0)
+        return;
+    m_sent_datagrams++;
+    m_sent_records += packet.size() / sensor_interface::RTD_RESPONSE_SIZE;
+}
+
+void VirtualNetbox::transmit()
+{
+    if(m_chance(m_random) < m_settings.loss)
+        return;
+    if(!m_held_packet && m_chance(m_random) < m_settings.reorder)
+    {
+        m_held_packet = m_packet;
+        return;
+    }
+    send(m_packet);
+    if(m_chance(m_random) < m_settings.duplicate)
+        send(m_packet);
+    if(m_held_packet)
+    {
+        send(*m_held_packet);
+        m_held_packet.reset();
+    }
+}
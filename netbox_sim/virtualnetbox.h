@@ -0,0 +1,81 @@
+#ifndef ESTIMATION_NETBOX_SIM_VIRTUALNETBOX_H
+#define ESTIMATION_NETBOX_SIM_VIRTUALNETBOX_H
+
+#include "sensor_interface/netboxrdtclient.h"
+
+#include <array>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <optional>
+
+#include <netinet/in.h>
+
+namespace estimation::netbox_sim {
+struct SimulationSettings
+{
+    double rate = 7000.0;
+    uint32_t records_per_packet = 10;
+    uint32_t unit_count = 1;
+    double loss = 0.0;
+    double reorder = 0.0;
+    double duplicate = 0.0;
+    uint32_t counts_per_unit = 1000000u;
+    std::vector<std::array<int32_t, 6>> replay;
+};
+
+// One emulated Netbox listening for RDT requests on its own loopback address.
+class VirtualNetbox
+{
+public:
+    VirtualNetbox(const std::string &address, uint16_t port, const SimulationSettings &settings, uint32_t seed);
+    ~VirtualNetbox();
+
+    VirtualNetbox(const VirtualNetbox &) = delete;
+    VirtualNetbox &operator=(const VirtualNetbox &) = delete;
+
+    int nativeHandle() const;
+    const std::string &address() const;
+
+    void handleRequests();
+
+    bool isStreaming() const;
+    std::chrono::steady_clock::time_point nextSampleTime() const;
+    void emitDueSamples(std::chrono::steady_clock::time_point now);
+
+    uint64_t sentDatagrams() const;
+    uint64_t sentRecords() const;
+
+private:
+    int m_fd;
+    std::string m_address;
+    SimulationSettings m_settings;
+    std::mt19937 m_random;
+    std::normal_distribution<double> m_noise;
+    std::uniform_real_distribution<double> m_chance;
+
+    sockaddr_in m_peer;
+    bool m_streaming;
+    sensor_interface::RTDCommand m_command;
+    uint64_t m_samples_left;
+    uint64_t m_sample_index;
+    std::chrono::steady_clock::time_point m_next_sample;
+    std::vector<uint32_t> m_rdt_sequence;
+    std::array<int32_t, 6> m_bias;
+    uint32_t m_status;
+
+    std::vector<unsigned char> m_packet;
+    std::optional<std::vector<unsigned char>> m_held_packet;
+    uint64_t m_sent_datagrams;
+    uint64_t m_sent_records;
+
+    void start(sensor_interface::RTDCommand command, uint32_t sample_count, const sockaddr_in &peer);
+    std::array<int32_t, 6> sampleCounts(uint32_t unit);
+    void appendRecord(uint32_t unit, const std::array<int32_t, 6> &counts);
+    void send(const std::vector<unsigned char> &packet);
+    void transmit();
+};
+}
+
+#endif
@@ -0,0 +1,99 @@
+#include "sensor_interface/sensorcontroller.h"
+#include "sensor_interface/remotesamplestream.h"
+
+#include <cmath>
+#include <mutex>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <exception>
+
+using namespace estimation::sensor_interface;
+
+namespace {
+constexpr std::size_t SAMPLES = 2000u;
+
+int failures = 0;
+
+void check(bool condition, const char *address, const char *what)
+{
+    if(condition)
+        return;
+    std::fprintf(stderr, "%s: %s\n", address, what);
+    failures++;
+}
+
+// Publishes SAMPLES samples through a loopback round trip and checks that every one arrives in order and intact.
+void roundTrip(const char *address, uint16_t port)
+{
+    SensorController controller(SAMPLES);
+    RemoteStreamSettings settings;
+    settings.address = address;
+    settings.port = port;
+    settings.stream_id = port;
+    settings.latency_bound = std::chrono::milliseconds(5);
+
+    RemoteSampleSubscriber subscriber(settings);
+    std::mutex lock;
+    std::vector<SensorSample> received;
+    subscriber.addSampleListener([&](const SensorSample &sample)
+    {
+        std::lock_guard<std::mutex> l(lock);
+        received.push_back(sample);
+    });
+
+    std::vector<SensorSample> sent;
+    controller.addSensorSampleListener([&](const SensorSample &sample)
+    {
+        sent.push_back(sample);
+    });
+    {
+        RemoteSamplePublisher publisher(controller, settings);
+        for(std::size_t i = 0; i < SAMPLES; i++)
+        {
+            RTDResponse response{};
+            response.fx = static_cast<int32_t>(1000 * i);
+            response.tz = -static_cast<int32_t>(37 * i);
+            controller.ingest(std::span<const RTDResponse>(&response, 1u));
+        }
+        auto last = subscriber.waitForNext(SAMPLES - 1u, std::chrono::seconds(2));
+        check(last && last->sequence == SAMPLES, address, "last sample did not arrive");
+        auto statistics = publisher.statistics();
+        check(statistics.samples == SAMPLES && statistics.dropped == 0u, address, "publisher dropped datagrams");
+    }
+
+    std::lock_guard<std::mutex> l(lock);
+    check(received.size() == SAMPLES, address, "samples were lost");
+    for(std::size_t i = 0; i < std::min(received.size(), sent.size()); i++)
+    {
+        bool intact = received[i].sequence == sent[i].sequence && received[i].timestamp == sent[i].timestamp;
+        for(std::size_t channel = 0; channel < 6u; channel++)
+            intact &= std::abs(received[i].load[channel] - sent[i].load[channel]) <= 1e-6 * std::abs(sent[i].load[channel]) + 1e-9;
+        if(!intact)
+        {
+            check(false, address, "sample changed on the way");
+            break;
+        }
+    }
+    auto statistics = subscriber.statistics();
+    check(statistics.samples == SAMPLES && statistics.dropped == 0u && statistics.malformed == 0u, address,
+          "subscriber counted lost or malformed datagrams");
+    std::printf("%s: %zu/%zu samples, %llu datagrams\n", address, received.size(), SAMPLES,
+                static_cast<unsigned long long>(statistics.datagrams));
+}
+}
+
+int main()
+{
+    try
+    {
+        roundTrip("127.0.0.1", 49210u);
+        roundTrip("239.255.42.1", 49211u);
+    }
+    catch(const std::exception &e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,230 @@
+#include "sensor_interface/netboxrdtclient.h"
+#include "sensor_interface/staticsensorcontroller.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+using namespace estimation::sensor_interface;
+
+namespace {
+std::atomic<uint64_t> allocations{0};
+}
+
+// Count every heap allocation, including Eigen's, which calls malloc directly rather than operator new.
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *pointer, std::size_t size);
+void *__libc_memalign(std::size_t alignment, std::size_t size);
+
+void *malloc(std::size_t size)
+{
+    allocations.fetch_add(1u, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(std::size_t count, std::size_t size)
+{
+    allocations.fetch_add(1u, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, std::size_t size)
+{
+    allocations.fetch_add(1u, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+
+void *aligned_alloc(std::size_t alignment, std::size_t size)
+{
+    allocations.fetch_add(1u, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **pointer, std::size_t alignment, std::size_t size)
+{
+    allocations.fetch_add(1u, std::memory_order_relaxed);
+    *pointer = __libc_memalign(alignment, size);
+    return *pointer ? 0 : ENOMEM;
+}
+}
+
+namespace {
+constexpr const char *ADDRESS = "127.0.0.4";
+constexpr uint16_t PORT = 49220u;
+constexpr uint32_t UNITS = 3u;
+constexpr uint64_t WARMUP_SAMPLES = 500u;
+constexpr uint64_t MEASURED_SAMPLES = 3000u;
+
+int failures = 0;
+
+struct CountingSink
+{
+    uint64_t samples = 0;
+    double fz = 0.0;
+
+    void operator()(const SensorSample &sample)
+    {
+        samples++;
+        fz += sample.load[2];
+    }
+};
+
+// Runs netbox_sim on its own loopback address and waits until it reports its socket bound.
+class Simulator
+{
+public:
+    explicit Simulator(const char *program)
+    {
+        int pipe_fds[2];
+        if(::pipe(pipe_fds) != 0)
+            throw std::runtime_error(std::string("pipe: ") + std::strerror(errno));
+        auto port = std::to_string(PORT);
+        auto units = std::to_string(UNITS);
+        m_pid = ::fork();
+        if(m_pid < 0)
+            throw std::runtime_error(std::string("fork: ") + std::strerror(errno));
+        if(m_pid == 0)
+        {
+            ::dup2(pipe_fds[1], STDERR_FILENO);
+            ::close(pipe_fds[0]);
+            ::close(pipe_fds[1]);
+            ::execl(program, program, "--address", ADDRESS, "--port", port.c_str(), "--units", units.c_str(),
+                    "--records", "10", static_cast<char*>(nullptr));
+            ::_exit(127);
+        }
+        ::close(pipe_fds[1]);
+        m_output = pipe_fds[0];
+
+        std::string output;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while(output.find("listening") == std::string::npos)
+        {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            pollfd descriptor{m_output, POLLIN, 0};
+            char buffer[256];
+            ssize_t read = 0;
+            if(left.count() <= 0 || ::poll(&descriptor, 1, static_cast<int>(left.count())) <= 0
+               || (read = ::read(m_output, buffer, sizeof(buffer))) <= 0)
+            {
+                stop();
+                throw std::runtime_error("netbox_sim did not start: " + output);
+            }
+            output.append(buffer, static_cast<std::size_t>(read));
+        }
+    }
+
+    ~Simulator()
+    {
+        stop();
+    }
+
+private:
+    void stop()
+    {
+        if(m_pid > 0)
+        {
+            ::kill(m_pid, SIGTERM);
+            ::waitpid(m_pid, nullptr, 0);
+            m_pid = -1;
+        }
+        if(m_output >= 0)
+        {
+            ::close(m_output);
+            m_output = -1;
+        }
+    }
+
+    pid_t m_pid = -1;
+    int m_output = -1;
+};
+
+// Polls until the sink has seen at least `samples` samples; false on timeout.
+bool pollUntil(NetboxRdtClient &client, StaticSensorController<CountingSink> &controller, uint64_t samples)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while(controller.sink().samples < samples)
+    {
+        if(std::chrono::steady_clock::now() > deadline)
+            return false;
+        pollfd descriptor{client.nativeHandle(), POLLIN, 0};
+        ::poll(&descriptor, 1, 10);
+        controller.poll(client);
+        client.watchdog();
+    }
+    return true;
+}
+
+// Streams one command through StaticSensorController::poll() and checks that the steady state never allocates.
+void steadyState(const char *name, RTDCommand command, uint32_t unit_count)
+{
+    NetboxStreamSettings settings;
+    settings.command = command;
+    settings.unit_count = unit_count;
+    settings.receive_thread = false;
+    settings.receive_buffer_size = 4 * 1024 * 1024;
+
+    NetboxRdtClient client;
+    StaticSensorController<CountingSink> controller;
+    controller.setUnit(unit_count - 1u);
+    client.openStream(ADDRESS, PORT, settings);
+
+    if(!pollUntil(client, controller, WARMUP_SAMPLES))
+    {
+        std::fprintf(stderr, "%s: no samples during warm-up\n", name);
+        failures++;
+        return;
+    }
+    auto allocations_before = allocations.load();
+    auto samples_before = controller.sink().samples;
+    bool streamed = pollUntil(client, controller, samples_before + MEASURED_SAMPLES);
+    auto allocated = allocations.load() - allocations_before;
+    auto samples = controller.sink().samples - samples_before;
+    client.stopStreaming();
+
+    std::printf("%s: %llu samples, %llu allocations\n", name, static_cast<unsigned long long>(samples),
+                static_cast<unsigned long long>(allocated));
+    if(!streamed)
+    {
+        std::fprintf(stderr, "%s: stream stalled\n", name);
+        failures++;
+    }
+    if(allocated != 0u)
+    {
+        std::fprintf(stderr, "%s: steady-state poll() allocated\n", name);
+        failures++;
+    }
+}
+}
+
+int main(int argc, char **argv)
+{
+    if(argc < 2)
+    {
+        std::fprintf(stderr, "Usage: %s <netbox_sim>\n", argv[0]);
+        return 1;
+    }
+    try
+    {
+        Simulator simulator(argv[1]);
+        steadyState("realtime", RTDCommand::START_HIGH_SPEED_REALTIME_STREAM, 1u);
+        steadyState("buffered", RTDCommand::START_HIGH_SPEED_BUFFERED_STREAM, 1u);
+        steadyState("multi-unit", RTDCommand::START_MULTI_UNIT_STREAMING, UNITS);
+    }
+    catch(const std::exception &e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}